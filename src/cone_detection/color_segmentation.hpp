@@ -0,0 +1,288 @@
+// Colour segmentation straight from a frame's pixel layout: every pixel is
+// read in place, converted to OpenCV's 8-bit HSV in registers and compared
+// against all colour ranges in the same pass. No BGR or HSV image is ever
+// materialized; the only outputs are the masks. Results are identical to
+// cv::cvtColor(..., COLOR_BGR2HSV) followed by cv::inRange().
+#ifndef COLOR_SEGMENTATION_H
+#define COLOR_SEGMENTATION_H
+
+#include <shared_memory/pixel_format.hpp>
+#include <opencv2/core/core.hpp>
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+// Inclusive bounds in OpenCV's 8-bit HSV: H in [0, 180), S and V in [0, 255].
+struct HsvRange {
+    std::array<int, 3> m_lower;
+    std::array<int, 3> m_upper;
+};
+
+inline HsvRange hsvRange(const cv::Scalar& lower, const cv::Scalar& upper) {
+    auto bound = [](double value) { return std::min(std::max(static_cast<int>(std::lround(value)), -1), 256); };
+    return HsvRange { { { bound(lower[0]), bound(lower[1]), bound(lower[2]) } }, { { bound(upper[0]), bound(upper[1]), bound(upper[2]) } } };
+}
+
+// Fixed point BGR to HSV, bit for bit as OpenCV's RGB2HSV_b.
+class HsvConversion {
+   public:
+    static const HsvConversion& instance() {
+        static const HsvConversion CONVERSION;
+        return CONVERSION;
+    }
+
+    void convert(int b, int g, int r, int& h, int& s, int& v) const noexcept {
+        v = std::max(std::max(b, g), r);
+        const int DIFF { v - std::min(std::min(b, g), r) };
+        const int VR { (v == r) ? -1 : 0 };
+        const int VG { (v == g) ? -1 : 0 };
+        s = (DIFF * m_sdiv[static_cast<std::size_t>(v)] + (1 << (SHIFT - 1))) >> SHIFT;
+        h = (VR & (g - b)) + (~VR & ((VG & (b - r + 2 * DIFF)) + (~VG & (r - g + 4 * DIFF))));
+        h = (h * m_hdiv[static_cast<std::size_t>(DIFF)] + (1 << (SHIFT - 1))) >> SHIFT;
+        h += (h < 0) ? 180 : 0;
+    }
+
+   private:
+    static constexpr int SHIFT { 12 };
+
+    HsvConversion()
+        : m_sdiv()
+        , m_hdiv() {
+        m_sdiv[0] = m_hdiv[0] = 0;
+        for (std::size_t i { 1 }; i < m_sdiv.size(); i++) {
+            m_sdiv[i] = static_cast<int>(std::lround((255 << SHIFT) / (1.0 * static_cast<double>(i))));
+            m_hdiv[i] = static_cast<int>(std::lround((180 << SHIFT) / (6.0 * static_cast<double>(i))));
+        }
+    }
+
+    std::array<int, 256> m_sdiv;
+    std::array<int, 256> m_hdiv;
+};
+
+// Reads the B, G and R values of one row's pixels in a given layout.
+template <PixelFormat FORMAT>
+class PixelRow;
+
+// Packed formats: STRIDE bytes per pixel with B, G and R at the given offsets.
+template <int STRIDE, int B, int G, int R>
+class PackedPixelRow {
+   public:
+    PackedPixelRow(const cv::Mat& frame, int row) noexcept
+        : m_row(frame.ptr<uint8_t>(row)) {}
+
+    void bgr(int x, int& b, int& g, int& r) const noexcept {
+        const uint8_t* pixel { m_row + x * STRIDE };
+        b = pixel[B];
+        g = pixel[G];
+        r = pixel[R];
+    }
+
+   private:
+    const uint8_t* m_row;
+};
+
+template <>
+class PixelRow<PixelFormat::BGRA> : public PackedPixelRow<4, 0, 1, 2> {
+    using PackedPixelRow::PackedPixelRow;
+};
+
+template <>
+class PixelRow<PixelFormat::ARGB> : public PackedPixelRow<4, 3, 2, 1> {
+    using PackedPixelRow::PackedPixelRow;
+};
+
+template <>
+class PixelRow<PixelFormat::BGR> : public PackedPixelRow<3, 0, 1, 2> {
+    using PackedPixelRow::PackedPixelRow;
+};
+
+// Fixed point BT.601 YUV to BGR, bit for bit as OpenCV's COLOR_YUV2BGR_I420.
+inline void yuvToBgr(int y, int u, int v, int& b, int& g, int& r) noexcept {
+    constexpr int SHIFT { 20 };
+    constexpr int CY { 1220542 };
+    constexpr int CUB { 2116026 };
+    constexpr int CUG { -409993 };
+    constexpr int CVG { -852492 };
+    constexpr int CVR { 1673527 };
+    auto saturate = [](int value) { return std::min(std::max(value, 0), 255); };
+    const int Y { std::max(0, y - 16) * CY };
+    u -= 128;
+    v -= 128;
+    r = saturate((Y + CVR * v + (1 << (SHIFT - 1))) >> SHIFT);
+    g = saturate((Y + CVG * v + CUG * u + (1 << (SHIFT - 1))) >> SHIFT);
+    b = saturate((Y + CUB * u + (1 << (SHIFT - 1))) >> SHIFT);
+}
+
+// YUV 4:2:0 frames are a continuous single channel matrix of height * 3 / 2
+// rows: the Y plane followed by the chroma at half resolution, either as U and
+// V planes (I420) or as one plane of interleaved U and V (NV12).
+inline int lumaRows(const cv::Mat& frame) noexcept {
+    return frame.rows * 2 / 3;
+}
+
+template <>
+class PixelRow<PixelFormat::I420> {
+   public:
+    PixelRow(const cv::Mat& frame, int row) noexcept
+        : m_y(frame.ptr<uint8_t>(row))
+        , m_u(frame.ptr<uint8_t>(0) + frame.cols * lumaRows(frame) + (row / 2) * (frame.cols / 2))
+        , m_v(m_u + (frame.cols / 2) * (lumaRows(frame) / 2)) {}
+
+    void bgr(int x, int& b, int& g, int& r) const noexcept {
+        yuvToBgr(m_y[x], m_u[x / 2], m_v[x / 2], b, g, r);
+    }
+
+   private:
+    const uint8_t* m_y;
+    const uint8_t* m_u;
+    const uint8_t* m_v;
+};
+
+template <>
+class PixelRow<PixelFormat::NV12> {
+   public:
+    PixelRow(const cv::Mat& frame, int row) noexcept
+        : m_y(frame.ptr<uint8_t>(row))
+        , m_uv(frame.ptr<uint8_t>(0) + frame.cols * lumaRows(frame) + (row / 2) * frame.cols) {}
+
+    void bgr(int x, int& b, int& g, int& r) const noexcept {
+        const uint8_t* uv { m_uv + (x / 2) * 2 };
+        yuvToBgr(m_y[x], uv[0], uv[1], b, g, r);
+    }
+
+   private:
+    const uint8_t* m_y;
+    const uint8_t* m_uv;
+};
+
+// Writes 255 into masks[i] where the pixel of frame within roi lies in ranges[i],
+// and 0 elsewhere. Masks are (re)allocated only if roi's size changed.
+template <PixelFormat FORMAT, std::size_t N>
+void segmentColors(const cv::Mat& frame, const cv::Rect& roi, const std::array<HsvRange, N>& ranges, std::array<cv::Mat, N>& masks) {
+    const HsvConversion& HSV { HsvConversion::instance() };
+    for (cv::Mat& mask : masks) {
+        mask.create(roi.height, roi.width, CV_8UC1);
+    }
+    std::array<uint8_t*, N> out;
+    for (int y { 0 }; y < roi.height; y++) {
+        const PixelRow<FORMAT> PIXELS { frame, roi.y + y };
+        for (std::size_t i { 0 }; i < N; i++) {
+            out[i] = masks[i].template ptr<uint8_t>(y);
+        }
+        for (int x { 0 }; x < roi.width; x++) {
+            int b, g, r, h, s, v;
+            PIXELS.bgr(roi.x + x, b, g, r);
+            HSV.convert(b, g, r, h, s, v);
+            for (std::size_t i { 0 }; i < N; i++) {
+                const HsvRange& RANGE { ranges[i] };
+                const bool INSIDE { (RANGE.m_lower[0] <= h) && (h <= RANGE.m_upper[0]) && (RANGE.m_lower[1] <= s) && (s <= RANGE.m_upper[1]) && (RANGE.m_lower[2] <= v) && (v <= RANGE.m_upper[2]) };
+                out[i][x] = INSIDE ? 255 : 0;
+            }
+        }
+    }
+}
+
+// Dispatches to the kernel for a run-time pixel format; false if there is none.
+template <std::size_t N>
+bool segmentColors(PixelFormat format, const cv::Mat& frame, const cv::Rect& roi, const std::array<HsvRange, N>& ranges, std::array<cv::Mat, N>& masks) {
+    switch (format) {
+        case PixelFormat::BGRA: segmentColors<PixelFormat::BGRA>(frame, roi, ranges, masks); return true;
+        case PixelFormat::ARGB: segmentColors<PixelFormat::ARGB>(frame, roi, ranges, masks); return true;
+        case PixelFormat::BGR: segmentColors<PixelFormat::BGR>(frame, roi, ranges, masks); return true;
+        case PixelFormat::I420: segmentColors<PixelFormat::I420>(frame, roi, ranges, masks); return true;
+        case PixelFormat::NV12: segmentColors<PixelFormat::NV12>(frame, roi, ranges, masks); return true;
+        default: return false;
+    }
+}
+
+// Inclusive bounds on the chroma of a YUV 4:2:0 frame, plus a minimum luma.
+struct ChromaRange {
+    int m_lowerY;
+    int m_lowerU;
+    int m_upperU;
+    int m_lowerV;
+    int m_upperV;
+};
+
+// Reads one row of a YUV 4:2:0 frame at chroma resolution: each value stands
+// for a 2x2 pixel block, whose luma is sampled at its top left pixel.
+template <PixelFormat FORMAT>
+class ChromaRow;
+
+template <>
+class ChromaRow<PixelFormat::I420> {
+   public:
+    ChromaRow(const cv::Mat& frame, int row) noexcept
+        : m_y(frame.ptr<uint8_t>(row * 2))
+        , m_u(frame.ptr<uint8_t>(0) + frame.cols * lumaRows(frame) + row * (frame.cols / 2))
+        , m_v(m_u + (frame.cols / 2) * (lumaRows(frame) / 2)) {}
+
+    void yuv(int x, int& y, int& u, int& v) const noexcept {
+        y = m_y[x * 2];
+        u = m_u[x];
+        v = m_v[x];
+    }
+
+   private:
+    const uint8_t* m_y;
+    const uint8_t* m_u;
+    const uint8_t* m_v;
+};
+
+template <>
+class ChromaRow<PixelFormat::NV12> {
+   public:
+    ChromaRow(const cv::Mat& frame, int row) noexcept
+        : m_y(frame.ptr<uint8_t>(row * 2))
+        , m_uv(frame.ptr<uint8_t>(0) + frame.cols * lumaRows(frame) + row * frame.cols) {}
+
+    void yuv(int x, int& y, int& u, int& v) const noexcept {
+        y = m_y[x * 2];
+        u = m_uv[x * 2];
+        v = m_uv[x * 2 + 1];
+    }
+
+   private:
+    const uint8_t* m_y;
+    const uint8_t* m_uv;
+};
+
+// Writes 255 into masks[i] where the chroma of frame within roi lies in
+// ranges[i], and 0 elsewhere. roi and the masks are at chroma resolution, half
+// the frame's width and height, so this touches a quarter of the pixels and
+// never converts to BGR or HSV.
+template <PixelFormat FORMAT, std::size_t N>
+void segmentChroma(const cv::Mat& frame, const cv::Rect& roi, const std::array<ChromaRange, N>& ranges, std::array<cv::Mat, N>& masks) {
+    for (cv::Mat& mask : masks) {
+        mask.create(roi.height, roi.width, CV_8UC1);
+    }
+    std::array<uint8_t*, N> out;
+    for (int y { 0 }; y < roi.height; y++) {
+        const ChromaRow<FORMAT> CHROMA { frame, roi.y + y };
+        for (std::size_t i { 0 }; i < N; i++) {
+            out[i] = masks[i].template ptr<uint8_t>(y);
+        }
+        for (int x { 0 }; x < roi.width; x++) {
+            int luma, u, v;
+            CHROMA.yuv(roi.x + x, luma, u, v);
+            for (std::size_t i { 0 }; i < N; i++) {
+                const ChromaRange& RANGE { ranges[i] };
+                const bool INSIDE { (RANGE.m_lowerY <= luma) && (RANGE.m_lowerU <= u) && (u <= RANGE.m_upperU) && (RANGE.m_lowerV <= v) && (v <= RANGE.m_upperV) };
+                out[i][x] = INSIDE ? 255 : 0;
+            }
+        }
+    }
+}
+
+template <std::size_t N>
+bool segmentChroma(PixelFormat format, const cv::Mat& frame, const cv::Rect& roi, const std::array<ChromaRange, N>& ranges, std::array<cv::Mat, N>& masks) {
+    switch (format) {
+        case PixelFormat::I420: segmentChroma<PixelFormat::I420>(frame, roi, ranges, masks); return true;
+        case PixelFormat::NV12: segmentChroma<PixelFormat::NV12>(frame, roi, ranges, masks); return true;
+        default: return false;
+    }
+}
+
+#endif
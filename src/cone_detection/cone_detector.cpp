@@ -1,139 +1,78 @@
 #include "cone_detector.hpp"
-#include <opencv2/highgui/highgui.hpp>
 #include <opencv2/imgproc/imgproc.hpp>
-#include <opencv2/opencv.hpp>
 #include <vector>
 
-#define LEN_CONES 2
-#define Y_START 0.55
-#define Y_END 0.23
-
-const cv::Scalar LOWER_BLUE = cv::Scalar(100, 100, 0);
-const cv::Scalar HIGHER_BLUE = cv::Scalar(140, 255, 255);
-const cv::Scalar LOWER_YELLOW = cv::Scalar(16, 0, 143);
-const cv::Scalar HIGHER_YELLOW = cv::Scalar(39, 255, 255);
-
-const std::vector<cv::Scalar> LOWER_BOUNDS = { LOWER_BLUE, LOWER_YELLOW };
-const std::vector<cv::Scalar> UPPER_BOUNDS = { HIGHER_BLUE, HIGHER_YELLOW };
-
-std::pair<cv::Point, cv::Point> detect_cones(cv::Mat& img) {
-    cv::Mat roi = get_roi(img);
-    cv::Point mid(roi.cols / 2, roi.rows);
-    std::vector<cv::Point> points(2, cv::Point(-1, -1));
-    //img = roi;
-
-    cv::Point start(img.cols / 2, 0);
-    cv::Point end(img.cols / 2, img.rows);
-
-    int thickness = 2;
-    int type = cv::LINE_8;
-
-    cv::line(img, start, end, cv::Scalar(255, 0, 0), thickness, type);
-
-    for (int i = 0; i < LEN_CONES; i++) {
-        cv::Mat hsv = get_hsv(roi, LOWER_BOUNDS.at(i), UPPER_BOUNDS.at(i));
-
-        cv::Point temp = find_conts(hsv, img);
-        std::cout << "Closest point: (" << temp.x << ", " << temp.y << ")" << std::endl;
-        if (i == 0) { // Blue cone
-            points[0] = temp; // Left
-        } else { // Yellow cone
-            points[1] = temp; // Right
+// Thresholds of the Canny edge detection on the 0/255 masks.
+static const int CANNY_LOW_THRESHOLD { 50 };
+static const int CANNY_HIGH_THRESHOLD { 150 };
+
+// The search ends at the first contour larger than minimumArea and reports the
+// lowest contour seen up to there. Returns the index of the contour that ended
+// it, or -1.
+static int nearestCone(const std::vector<cv::Rect>& contours, int minimumArea, cv::Rect& nearest) {
+    nearest = cv::Rect();
+    for (std::size_t i { 0 }; i < contours.size(); i++) {
+        if (contours[i].y > nearest.y) {
+            nearest = contours[i];
+        }
+        if (contours[i].area() > minimumArea) {
+            return static_cast<int>(i);
         }
     }
-
-    cv::Point pt(-1, -1);
-    // If no points were detected
-    if ((points[0].x == -1 && points[0].y == -1) && (points[1].x == -1 && points[1].y == -1)) {
-        return { pt, pt };
-    }
-    // if point 0 was detected but not 1
-    else if ((points[0].x != -1 && points[0].y != -1) && (points[1].x == -1 && points[1].y == -1)) {
-        draw_circle(img, points[0], pt);
-        return { points[0], pt };
-    }
-    // if point 1 was detected but not 0
-    else if ((points[0].x == -1 && points[0].y == -1) && (points[1].x != -1 && points[1].y != -1)) {
-        draw_circle(img, pt, points[1]);
-        return { pt, points[1] };
-    }
-    // if both points are detected
-    else {
-        draw_circle(img, points[0], points[1]);
-        return { points[0], points[1] };
-    }
-
-
-}
-
-cv::Mat get_roi(cv::Mat& img) {
-    cv::Mat region(img, cv::Rect(0, (int)img.rows * Y_START, img.cols, (int)img.rows * Y_END));
-    return region;
+    return -1;
 }
 
-cv::Mat get_hsv(cv::Mat& img, cv::Scalar lower_bounds, cv::Scalar upper_bounds) {
-
-    cv::Mat hsv_img;
-    cv::cvtColor(img, hsv_img, cv::COLOR_BGR2HSV);
-
-    cv::Mat mask;
-    cv::inRange(hsv_img, lower_bounds, upper_bounds, mask);
-
-    return mask;
+ConeDetector::ConeDetector(const ConeDetectorOptions& options)
+    : m_options(options)
+    , m_ranges { { options.m_blue, options.m_yellow } }
+    , m_chromaRanges { { options.m_blueChroma, options.m_yellowChroma } }
+    , m_arena() {
 }
 
-cv::Point find_conts(cv::Mat& hsv_roi_img, cv::Mat& og_img) {
-
-    cv::Mat canny_output;
-    cv::Canny(hsv_roi_img, canny_output, 50, 150);
-
-    std::vector<std::vector<cv::Point>> contours;
-    findContours(canny_output, contours, cv::RETR_TREE, cv::CHAIN_APPROX_SIMPLE);
-    cv::Rect nearest;
-
-    // now we have all the contours now we need to draw them and display them
-    for (size_t i = 0; i < contours.size(); i++) {
+ConeResult ConeDetector::process(const FrameView& frame) {
+    ConeResult result;
+    // Shares the pixels, so annotations go into the frame.
+    cv::Mat image { frame.m_image };
+    if (image.empty()) {
+        return result;
+    }
 
-        cv::Rect bounding_rect = cv::boundingRect(contours[i]);
+    // YUV 4:2:0 frames are segmented on their chroma planes at half the
+    // resolution, all others on their pixels.
+    const bool YUV { (PixelFormat::I420 == frame.m_pixelFormat) || (PixelFormat::NV12 == frame.m_pixelFormat) };
+    const int SCALE { YUV ? 2 : 1 };
+    const int HEIGHT { YUV ? lumaRows(image) : image.rows };
+    const cv::Rect ROI { 0, static_cast<int>(HEIGHT * m_options.m_roiTop) / SCALE, image.cols / SCALE, static_cast<int>(HEIGHT * m_options.m_roiHeight) / SCALE };
+    m_arena.reset(ROI.size());
+    std::array<cv::Mat, FrameArena::NUMBER_OF_MASKS>& masks { m_arena.masks() };
+    if (!(YUV ? segmentChroma(frame.m_pixelFormat, image, ROI, m_chromaRanges, masks) : segmentColors(frame.m_pixelFormat, image, ROI, m_ranges, masks))) {
+        return result;
+    }
 
-        if (bounding_rect.y > nearest.y) {
-            nearest = bounding_rect;
+    const bool ANNOTATE { (ConeDetectorOptions::Output::ANNOTATED == m_options.m_output) && !YUV };
+    std::vector<cv::Point>& points { m_arena.points() };
+    for (std::size_t i { 0 }; i < masks.size(); i++) {
+        const std::vector<cv::Rect>& contours { m_arena.contours(masks[i], CANNY_LOW_THRESHOLD, CANNY_HIGH_THRESHOLD) };
+        cv::Rect nearest;
+        const int FOUND { nearestCone(contours, m_options.m_minimumArea / (SCALE * SCALE), nearest) };
+        points.push_back((0 > FOUND) ? cv::Point(-1, -1) : cv::Point((nearest.x + nearest.height) * SCALE, (nearest.y + nearest.height) * SCALE));
+        if (ANNOTATE && (0 <= FOUND)) {
+            cv::Rect box { contours[static_cast<std::size_t>(FOUND)] };
+            box.y += ROI.y;
+            cv::rectangle(image, box, cv::Scalar(0, 0, 255), 2, cv::LINE_8);
         }
+    }
+    result.m_left = points[0];
+    result.m_right = points[1];
 
-        // add back the cropped image height to the y coordinate
-        bounding_rect.y += (int)og_img.rows * Y_START;
-        float missing_y = (float)og_img.rows * Y_START;
-        if (bounding_rect.area() > 400) {
-            cv::rectangle(og_img, bounding_rect, cv::Scalar(0, 0, 255), 2, cv::LINE_8);
-            cv::Point pt(nearest.x + nearest.height, nearest.y + nearest.height);
-            cv::Point center(og_img.cols / 2, og_img.rows);
-            cv::Point rectangle_bottom(bounding_rect.x + bounding_rect.width / 2, bounding_rect.y + bounding_rect.height + missing_y);
-            //cv::line(og_img, center, rectangle_bottom, cv::Scalar(0,0,255), 2);
-
-
-            return pt;
+    if (ANNOTATE) {
+        cv::line(image, cv::Point(image.cols / 2, 0), cv::Point(image.cols / 2, image.rows), cv::Scalar(255, 0, 0), 2, cv::LINE_8);
+        if (-1 != result.m_left.x) {
+            cv::circle(image, result.m_left, 25, cv::Scalar(255, 0, 0), cv::FILLED, cv::LINE_8); // left is blue
+        }
+        if (-1 != result.m_right.x) {
+            cv::circle(image, result.m_right, 25, cv::Scalar(0, 255, 0), cv::FILLED, cv::LINE_8); // right is green
         }
     }
-
-    cv::Point pt(-1, -1);
-    return pt;
+    return result;
 }
-
-void draw_circle(cv::Mat& img, cv::Point left, cv::Point right) {
-    if (left.x != -1) {
-        cv::circle(img,
-            left,
-            25,
-            cv::Scalar(255, 0, 0), // left is blue
-            cv::FILLED,
-            cv::LINE_8);
-    }
-    if (right.x != -1) {
-        cv::circle(img,
-            right,
-            25,
-            cv::Scalar(0, 255, 0), // right is green
-            cv::FILLED,
-            cv::LINE_8);
-    }
-}
\ No newline at end of file
@@ -1,13 +1,66 @@
-// encapsualte the functions in order to be callables
+// Detection of the nearest blue (left) and yellow (right) cones in the region
+// ahead of the car. A ConeDetector is configured once and keeps all working
+// memory of its pipeline to itself, so detectors for several cameras can run
+// in parallel; a single detector is used by one thread at a time.
 #ifndef CONES_DETECTION_H
 #define CONES_DETECTION_H
 
-#include <opencv2/opencv.hpp>
-// cv::Point detect_cones(cv::Mat& img);
-std::pair<cv::Point, cv::Point> detect_cones(cv::Mat& img);
-cv::Mat get_roi(cv::Mat& img);
-cv::Mat get_hsv(cv::Mat& img, cv::Scalar lower_bounds, cv::Scalar upper_bounds);
-cv::Point find_conts(cv::Mat& hsv_roi_img, cv::Mat& og_img);
-// void draw_circle(cv::Mat& img, cv::Point pt);
-void draw_circle(cv::Mat& img, cv::Point left, cv::Point right);
-#endif
\ No newline at end of file
+#include "color_segmentation.hpp"
+#include "frame_arena.hpp"
+#include <shared_memory/pixel_format.hpp>
+#include <opencv2/core/core.hpp>
+
+// A frame's pixels in their layout, as a FrameSource delivers them; not owned.
+struct FrameView {
+    PixelFormat m_pixelFormat { PixelFormat::UNKNOWN };
+    cv::Mat m_image {};
+};
+
+struct ConeResult {
+    // Nearest cones in the ROI's coordinates at full resolution; (-1, -1) if
+    // there is none.
+    cv::Point m_left { -1, -1 };
+    cv::Point m_right { -1, -1 };
+};
+
+struct ConeDetectorOptions {
+    enum class Output { RESULT,
+        ANNOTATED };
+
+    // Cone colours for BGR based frames, in OpenCV's 8-bit HSV.
+    HsvRange m_blue { { { 100, 100, 0 } }, { { 140, 255, 255 } } };
+    HsvRange m_yellow { { { 16, 0, 143 } }, { { 39, 255, 255 } } };
+    // Cone colours for YUV 4:2:0 frames: the boxes best matching the HSV
+    // bounds above in BT.601 studio swing, as the h264 decoder produces it.
+    ChromaRange m_blueChroma { 0, 156, 255, 0, 163 };
+    ChromaRange m_yellowChroma { 112, 0, 103, 120, 171 };
+    // Top and height of the ROI as fractions of the frame's height.
+    double m_roiTop { 0.55 };
+    double m_roiHeight { 0.23 };
+    // Area of a cone's bounding box in pixels at full resolution.
+    int m_minimumArea { 400 };
+    // ANNOTATED draws the ROI's centre line, the cones' boxes and the result
+    // into BGR based frames.
+    Output m_output { Output::RESULT };
+};
+
+class ConeDetector {
+   private:
+    ConeDetector(const ConeDetector&) = delete;
+    ConeDetector(ConeDetector&&) = delete;
+    ConeDetector& operator=(const ConeDetector&) = delete;
+    ConeDetector& operator=(ConeDetector&&) = delete;
+
+   public:
+    explicit ConeDetector(const ConeDetectorOptions& options = ConeDetectorOptions());
+
+    ConeResult process(const FrameView& frame);
+
+   private:
+    const ConeDetectorOptions m_options;
+    const std::array<HsvRange, FrameArena::NUMBER_OF_MASKS> m_ranges;
+    const std::array<ChromaRange, FrameArena::NUMBER_OF_MASKS> m_chromaRanges;
+    FrameArena m_arena;
+};
+
+#endif
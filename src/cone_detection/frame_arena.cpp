@@ -0,0 +1,281 @@
+#include "frame_arena.hpp"
+#include <algorithm>
+#include <array>
+#include <cstdlib>
+#include <utility>
+
+FrameArena::FrameArena()
+    : m_size()
+    , m_masks()
+    , m_points()
+    , m_dx()
+    , m_dy()
+    , m_magnitudes()
+    , m_edgeMap()
+    , m_edgeStack()
+    , m_borders()
+    , m_contours()
+    , m_boxes() {
+}
+
+void FrameArena::reset(const cv::Size& roiSize) {
+    resize(roiSize);
+    m_points.clear();
+}
+
+void FrameArena::resize(const cv::Size& roiSize) {
+    if (roiSize != m_size) {
+        m_size = roiSize;
+        for (cv::Mat& mask : m_masks) {
+            mask.create(roiSize.height, roiSize.width, CV_8UC1);
+        }
+        const std::size_t PIXELS { static_cast<std::size_t>(roiSize.area()) };
+        const std::size_t PADDED_PIXELS { static_cast<std::size_t>(roiSize.width + 2) * static_cast<std::size_t>(roiSize.height + 2) };
+        m_dx.assign(PIXELS, 0);
+        m_dy.assign(PIXELS, 0);
+        m_magnitudes.assign(PADDED_PIXELS, 0);
+        m_edgeMap.assign(PADDED_PIXELS, 1);
+        // Every pixel becomes an edge at most once.
+        m_edgeStack.reserve(PIXELS);
+        m_borders.assign(PADDED_PIXELS, 0);
+        // A border starts where a row changes between 0 and non-zero, which
+        // happens at most width + 1 times per row; plus the frame.
+        const std::size_t CONTOURS { static_cast<std::size_t>(roiSize.width + 1) * static_cast<std::size_t>(roiSize.height) + 1 };
+        m_contours.reserve(CONTOURS);
+        m_boxes.reserve(CONTOURS);
+        m_points.reserve(NUMBER_OF_MASKS);
+    }
+}
+
+std::array<cv::Mat, FrameArena::NUMBER_OF_MASKS>& FrameArena::masks() noexcept {
+    return m_masks;
+}
+
+std::vector<cv::Point>& FrameArena::points() noexcept {
+    return m_points;
+}
+
+const std::vector<cv::Rect>& FrameArena::contours(const cv::Mat& mask, int lowThreshold, int highThreshold) {
+    resize(mask.size());
+    canny(mask, lowThreshold, highThreshold);
+    traceContours();
+
+    // cv::findContours lists the tree depth first, a contour before its
+    // children; the frame itself is not reported.
+    m_boxes.clear();
+    int32_t index { m_contours[0].m_firstChild };
+    while (0 < index) {
+        const Contour& contour { m_contours[static_cast<std::size_t>(index)] };
+        m_boxes.emplace_back(contour.m_box.m_left - 1, contour.m_box.m_top - 1, contour.m_box.m_right - contour.m_box.m_left + 1, contour.m_box.m_bottom - contour.m_box.m_top + 1);
+        if (-1 != contour.m_firstChild) {
+            index = contour.m_firstChild;
+            continue;
+        }
+        while ((0 < index) && (-1 == m_contours[static_cast<std::size_t>(index)].m_nextSibling)) {
+            index = m_contours[static_cast<std::size_t>(index)].m_parent;
+        }
+        if (0 < index) {
+            index = m_contours[static_cast<std::size_t>(index)].m_nextSibling;
+        }
+    }
+    return m_boxes;
+}
+
+void FrameArena::canny(const cv::Mat& mask, int lowThreshold, int highThreshold) {
+    // As cv::Canny with its default aperture of 3 and L1 gradient magnitudes.
+    const int WIDTH { mask.cols };
+    const int HEIGHT { mask.rows };
+    const int32_t STEP { WIDTH + 2 };
+    if (lowThreshold > highThreshold) {
+        std::swap(lowThreshold, highThreshold);
+    }
+
+    // 3x3 Sobel derivatives with replicated borders.
+    for (int y { 0 }; y < HEIGHT; y++) {
+        const uint8_t* above { mask.ptr<uint8_t>((0 < y) ? y - 1 : y) };
+        const uint8_t* row { mask.ptr<uint8_t>(y) };
+        const uint8_t* below { mask.ptr<uint8_t>((y + 1 < HEIGHT) ? y + 1 : y) };
+        int16_t* dx { m_dx.data() + static_cast<std::size_t>(y) * static_cast<std::size_t>(WIDTH) };
+        int16_t* dy { m_dy.data() + static_cast<std::size_t>(y) * static_cast<std::size_t>(WIDTH) };
+        int32_t* magnitudes { m_magnitudes.data() + (y + 1) * STEP + 1 };
+        for (int x { 0 }; x < WIDTH; x++) {
+            const int LEFT { (0 < x) ? x - 1 : x };
+            const int RIGHT { (x + 1 < WIDTH) ? x + 1 : x };
+            const int DX { (above[RIGHT] + 2 * row[RIGHT] + below[RIGHT]) - (above[LEFT] + 2 * row[LEFT] + below[LEFT]) };
+            const int DY { (below[LEFT] + 2 * below[x] + below[RIGHT]) - (above[LEFT] + 2 * above[x] + above[RIGHT]) };
+            dx[x] = static_cast<int16_t>(DX);
+            dy[x] = static_cast<int16_t>(DY);
+            magnitudes[x] = std::abs(DX) + std::abs(DY);
+        }
+    }
+
+    // Non-maximum suppression along the gradient's direction, quantized with
+    // tan(22.5 degrees) in 15 bit fixed point.
+    const int32_t TG22 { 13573 };
+    const int SHIFT { 15 };
+    m_edgeStack.clear();
+    for (int y { 0 }; y < HEIGHT; y++) {
+        const int16_t* dx { m_dx.data() + static_cast<std::size_t>(y) * static_cast<std::size_t>(WIDTH) };
+        const int16_t* dy { m_dy.data() + static_cast<std::size_t>(y) * static_cast<std::size_t>(WIDTH) };
+        const int32_t ROW { (y + 1) * STEP + 1 };
+        const int32_t* magnitudes { m_magnitudes.data() + ROW };
+        uint8_t* edgeMap { m_edgeMap.data() + ROW };
+        for (int x { 0 }; x < WIDTH; x++) {
+            const int32_t M { magnitudes[x] };
+            bool maximum { false };
+            if (M > lowThreshold) {
+                const int32_t XS { std::abs(dx[x]) };
+                const int32_t YS { std::abs(dy[x]) << SHIFT };
+                const int32_t TG22X { XS * TG22 };
+                if (YS < TG22X) {
+                    maximum = (M > magnitudes[x - 1]) && (M >= magnitudes[x + 1]);
+                } else if (YS > TG22X + (XS << (SHIFT + 1))) {
+                    maximum = (M > magnitudes[x - STEP]) && (M >= magnitudes[x + STEP]);
+                } else {
+                    const int32_t S { ((dx[x] ^ dy[x]) < 0) ? -1 : 1 };
+                    maximum = (M > magnitudes[x - STEP - S]) && (M > magnitudes[x + STEP + S]);
+                }
+            }
+            if (!maximum) {
+                edgeMap[x] = 1;
+            } else if (M > highThreshold) {
+                edgeMap[x] = 2;
+                m_edgeStack.push_back(ROW + x);
+            } else {
+                edgeMap[x] = 0;
+            }
+        }
+    }
+
+    // Hysteresis: candidates 8-connected to an edge become edges.
+    uint8_t* edgeMap { m_edgeMap.data() };
+    const std::array<int32_t, 8> NEIGHBOURS { { -STEP - 1, -STEP, -STEP + 1, -1, 1, STEP - 1, STEP, STEP + 1 } };
+    while (!m_edgeStack.empty()) {
+        const int32_t INDEX { m_edgeStack.back() };
+        m_edgeStack.pop_back();
+        for (const int32_t NEIGHBOUR : NEIGHBOURS) {
+            if (0 == edgeMap[INDEX + NEIGHBOUR]) {
+                edgeMap[INDEX + NEIGHBOUR] = 2;
+                m_edgeStack.push_back(INDEX + NEIGHBOUR);
+            }
+        }
+    }
+
+    // The map's border is 1 and the borders' is 0, both never written.
+    for (int y { 0 }; y < HEIGHT; y++) {
+        const int32_t ROW { (y + 1) * STEP + 1 };
+        for (int x { 0 }; x < WIDTH; x++) {
+            m_borders[static_cast<std::size_t>(ROW + x)] = (2 == edgeMap[ROW + x]) ? 1 : 0;
+        }
+    }
+}
+
+void FrameArena::traceContours() {
+    const int WIDTH { m_size.width + 2 };
+    const int HEIGHT { m_size.height + 2 };
+    int32_t* pixels { m_borders.data() };
+    m_contours.clear();
+    m_contours.push_back(Contour { Box { 0, 0, WIDTH - 1, HEIGHT - 1 }, true, -1, -1, -1 });
+
+    // OpenCV marks every border alike and only looks at pixels where that
+    // marking changes along a row.
+    auto kind = [](int32_t value) { return (0 > value) ? -1 : ((1 < value) ? 2 : value); };
+
+    // Raster scan as OpenCV's contour scanner: borders start where a row turns
+    // from 0 to 1 (outer) or from 1 or a positive label to 0 (hole).
+    for (int y { 1 }; y < HEIGHT - 1; y++) {
+        const int32_t ROW { y * WIDTH };
+        // Column of the pixel of the border last crossed on this row, 0 for the
+        // frame.
+        int32_t lastBorder { 0 };
+        for (int x { 1 }; x < WIDTH; x++) {
+            const int32_t PREVIOUS { pixels[ROW + x - 1] };
+            const int32_t VALUE { pixels[ROW + x] };
+            if (kind(PREVIOUS) == kind(VALUE)) {
+                continue;
+            }
+            const bool OUTER { (0 == PREVIOUS) && (1 == VALUE) };
+            const bool HOLE { (0 == VALUE) && (1 <= PREVIOUS) };
+            if (!OUTER && !HOLE) {
+                if ((0 != VALUE) && (1 != VALUE)) {
+                    lastBorder = x;
+                }
+                continue;
+            }
+            if (HOLE && (1 < PREVIOUS)) {
+                lastBorder = x - 1;
+            }
+
+            // The parent is the border last crossed, or its parent if both are
+            // outer borders or both holes.
+            int32_t parent { 0 };
+            if (0 < lastBorder) {
+                parent = std::abs(pixels[ROW + lastBorder]) - 1;
+                if (m_contours[static_cast<std::size_t>(parent)].m_isHole == HOLE) {
+                    parent = std::max(m_contours[static_cast<std::size_t>(parent)].m_parent, 0);
+                }
+            }
+            const int32_t START { ROW + x - (HOLE ? 1 : 0) };
+            const int32_t SIBLING { m_contours[static_cast<std::size_t>(parent)].m_firstChild };
+            const int32_t INDEX { static_cast<int32_t>(m_contours.size()) };
+            m_contours.push_back(Contour { Box { START % WIDTH, y, START % WIDTH, y }, HOLE, parent, -1, SIBLING });
+            m_contours[static_cast<std::size_t>(parent)].m_firstChild = INDEX;
+            traceBorder(START, HOLE, INDEX + 1);
+            lastBorder = START - ROW;
+        }
+    }
+}
+
+void FrameArena::traceBorder(int32_t start, bool isHole, int32_t label) {
+    const int32_t WIDTH { m_size.width + 2 };
+    // The 8 neighbours counter-clockwise from the right, twice to wrap around.
+    const std::array<int32_t, 16> DELTAS { { 1, 1 - WIDTH, -WIDTH, -1 - WIDTH, -1, WIDTH - 1, WIDTH, WIDTH + 1, 1, 1 - WIDTH, -WIDTH, -1 - WIDTH, -1, WIDTH - 1, WIDTH, WIDTH + 1 } };
+    int32_t* pixels { m_borders.data() };
+    Box& box { m_contours.back().m_box };
+
+    // Search clockwise from the 0 next to the start for the border's last pixel.
+    int32_t direction { isHole ? 0 : 4 };
+    int32_t end { direction };
+    int32_t last { start };
+    do {
+        direction = (direction - 1) & 7;
+        last = start + DELTAS[static_cast<std::size_t>(direction)];
+    } while ((0 == pixels[last]) && (direction != end));
+    if (direction == end) {
+        // A single pixel.
+        pixels[start] = -label;
+        return;
+    }
+
+    // Follow the border counter-clockwise until it returns to its start.
+    int32_t current { start };
+    for (;;) {
+        end = direction;
+        int32_t next { current };
+        while (direction < 15) {
+            next = current + DELTAS[static_cast<std::size_t>(++direction)];
+            if (0 != pixels[next]) {
+                break;
+            }
+        }
+        direction &= 7;
+        // Pixels whose right neighbour was found to be 0 end a run of the
+        // region on their row.
+        if (static_cast<uint32_t>(direction - 1) < static_cast<uint32_t>(end)) {
+            pixels[current] = -label;
+        } else if (1 == pixels[current]) {
+            pixels[current] = label;
+        }
+        const int X { current % WIDTH };
+        const int Y { current / WIDTH };
+        box.m_left = std::min(box.m_left, X);
+        box.m_right = std::max(box.m_right, X);
+        box.m_top = std::min(box.m_top, Y);
+        box.m_bottom = std::max(box.m_bottom, Y);
+        if ((next == start) && (current == last)) {
+            break;
+        }
+        current = next;
+        direction = (direction + 4) & 7;
+    }
+}
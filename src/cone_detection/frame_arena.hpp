@@ -0,0 +1,87 @@
+// Working memory of one perception pipeline for frames of one ROI size: the
+// colour masks, the buffers of the edge detection and contour tracing, and the
+// detected points. Everything is allocated when the ROI size changes; reset()
+// at the start of each frame is O(1) and reuses the buffers, so detection on a
+// stream of equally sized frames does not touch the heap.
+#ifndef FRAME_ARENA_H
+#define FRAME_ARENA_H
+
+#include <opencv2/core/core.hpp>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class FrameArena {
+   private:
+    FrameArena(const FrameArena&) = delete;
+    FrameArena(FrameArena&&) = delete;
+    FrameArena& operator=(const FrameArena&) = delete;
+    FrameArena& operator=(FrameArena&&) = delete;
+
+   public:
+    static constexpr std::size_t NUMBER_OF_MASKS { 2 };
+
+    FrameArena();
+
+    // Prepares the arena for a frame whose ROI has the given size.
+    void reset(const cv::Size& roiSize);
+
+    std::array<cv::Mat, NUMBER_OF_MASKS>& masks() noexcept;
+    std::vector<cv::Point>& points() noexcept;
+
+    // Bounding boxes of the contours in the Canny edges of mask, holes
+    // included, in the order of cv::Canny(mask, edges, lowThreshold,
+    // highThreshold) followed by cv::findContours(edges, RETR_TREE); valid
+    // until the next call.
+    const std::vector<cv::Rect>& contours(const cv::Mat& mask, int lowThreshold, int highThreshold);
+
+   private:
+    // (Re)allocates the buffers if size differs from the current ROI size.
+    void resize(const cv::Size& size);
+    // Marks the edges of mask as 1 in m_borders, everything else as 0.
+    void canny(const cv::Mat& mask, int lowThreshold, int highThreshold);
+    // Suzuki's border following on m_borders, building the contour tree.
+    void traceContours();
+    void traceBorder(int32_t start, bool isHole, int32_t label);
+
+   private:
+    // Inclusive corners in the padded images' coordinates.
+    struct Box {
+        int m_left;
+        int m_top;
+        int m_right;
+        int m_bottom;
+    };
+
+    // A border and its place in the contour tree; indices into m_contours,
+    // -1 for none. Children are prepended, as OpenCV does.
+    struct Contour {
+        Box m_box;
+        bool m_isHole;
+        int32_t m_parent;
+        int32_t m_firstChild;
+        int32_t m_nextSibling;
+    };
+
+    cv::Size m_size;
+    std::array<cv::Mat, NUMBER_OF_MASKS> m_masks;
+    std::vector<cv::Point> m_points;
+
+    // Sobel derivatives of the mask, and the gradient magnitudes and Canny's
+    // edge map (0: candidate, 1: no edge, 2: edge) with a one pixel border.
+    std::vector<int16_t> m_dx;
+    std::vector<int16_t> m_dy;
+    std::vector<int32_t> m_magnitudes;
+    std::vector<uint8_t> m_edgeMap;
+    std::vector<int32_t> m_edgeStack;
+
+    // The edges as 0/1 with a zero border; traced borders are marked with
+    // the label of their contour, negated where the pixel right of it is 0.
+    std::vector<int32_t> m_borders;
+    // m_contours[0] is the frame around the image.
+    std::vector<Contour> m_contours;
+    std::vector<cv::Rect> m_boxes;
+};
+
+#endif
@@ -0,0 +1,196 @@
+#include "frame_source.hpp"
+#include <chrono>
+#include <iostream>
+
+// Wraps a frame's pixels without copying; empty for unknown formats.
+static cv::Mat wrap(PixelFormat format, uint32_t width, uint32_t height, void* data) {
+    const int ROWS { static_cast<int>(height) };
+    const int COLS { static_cast<int>(width) };
+    switch (format) {
+        case PixelFormat::BGRA:
+        case PixelFormat::ARGB: return cv::Mat(ROWS, COLS, CV_8UC4, data);
+        case PixelFormat::BGR: return cv::Mat(ROWS, COLS, CV_8UC3, data);
+        case PixelFormat::I420:
+        case PixelFormat::NV12: return cv::Mat(ROWS * 3 / 2, COLS, CV_8UC1, data);
+        default: return cv::Mat();
+    }
+}
+
+FrameSource::FrameSource(std::size_t index, const std::string& name, uint32_t width, uint32_t height, PixelFormat format, const FrameSharedMemoryOptions& placement, uint32_t spins, Delegate delegate)
+    : m_index(index)
+    , m_pixelFormat(format)
+    , m_spins(spins)
+    , m_delegate(std::move(delegate))
+    , m_frames(name, 0, 0, placement)
+    , m_sharedMemory()
+    , m_name()
+    , m_mutex()
+    , m_geometry { 0, 0, format }
+    , m_pool()
+    , m_running(true)
+    , m_captureStopped(false)
+    , m_numberOfDroppedFrames(0)
+    , m_lastFrameTime(std::chrono::steady_clock::now().time_since_epoch().count())
+    , m_captureThread() {
+    // Areas from a FrameSharedMemory producer carry the frame metadata in their
+    // header, all others are cluon::SharedMemory.
+    if (m_frames.valid()) {
+        m_name = m_frames.name();
+        m_captureThread = std::thread(&FrameSource::captureFrameSharedMemory, this);
+    } else {
+        m_sharedMemory.reset(new cluon::SharedMemory { name });
+        if (m_sharedMemory->valid()) {
+            m_name = m_sharedMemory->name();
+            if ((0 < width) && (0 < height)) {
+                setGeometry(Geometry { width, height, format });
+            }
+            m_captureThread = std::thread(&FrameSource::captureSharedMemory, this);
+        }
+    }
+}
+
+FrameSource::~FrameSource() {
+    m_running.store(false);
+    if (m_sharedMemory && m_sharedMemory->valid() && m_captureThread.joinable()) {
+        // Wakes the capture thread from cluon::SharedMemory::wait(). The wait has
+        // no predicate, so a notification sent between the thread's check of
+        // m_running and its wait is lost; repeat it until the thread returned,
+        // as a dead producer would never notify again.
+        while (!m_captureStopped.load()) {
+            m_sharedMemory->notifyAll();
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+    if (m_captureThread.joinable()) {
+        m_captureThread.join();
+    }
+}
+
+bool FrameSource::valid() const noexcept {
+    return m_captureThread.joinable();
+}
+
+const std::string& FrameSource::name() const noexcept {
+    return m_name;
+}
+
+uint32_t FrameSource::size() const noexcept {
+    return m_frames.valid() ? m_frames.size() : (m_sharedMemory ? m_sharedMemory->size() : 0);
+}
+
+uint64_t FrameSource::numberOfDroppedFrames() const noexcept {
+    return m_numberOfDroppedFrames.load(std::memory_order_relaxed);
+}
+
+std::chrono::steady_clock::time_point FrameSource::lastFrameTime() const noexcept {
+    return std::chrono::steady_clock::time_point(std::chrono::steady_clock::duration(m_lastFrameTime.load(std::memory_order_relaxed)));
+}
+
+bool FrameSource::reconfigure(uint32_t width, uint32_t height, uint32_t bytesPerPixel) {
+    if (m_frames.valid()) {
+        return true;
+    }
+    PixelFormat format { m_pixelFormat };
+    if ((PixelFormat::I420 != format) && (PixelFormat::NV12 != format)) {
+        format = (4 == bytesPerPixel) ? m_pixelFormat : ((3 == bytesPerPixel) ? PixelFormat::BGR : PixelFormat::UNKNOWN);
+    }
+    return setGeometry(Geometry { width, height, format });
+}
+
+bool FrameSource::setGeometry(const Geometry& geometry) {
+    const uint64_t SIZE { frameSize(geometry.m_pixelFormat, geometry.m_width, geometry.m_height) };
+    if (!m_sharedMemory || !m_sharedMemory->valid() || (0 == SIZE) || (SIZE > static_cast<uint64_t>(m_sharedMemory->size()))) {
+        std::cerr << "[FrameSource]: Ignoring geometry " << geometry.m_width << "x" << geometry.m_height << " for " << m_name << "." << std::endl;
+        return false;
+    }
+    std::lock_guard<std::mutex> lck(m_mutex);
+    if ((geometry.m_width != m_geometry.m_width) || (geometry.m_height != m_geometry.m_height) || (geometry.m_pixelFormat != m_geometry.m_pixelFormat)) {
+        // Pooled images are resized by the next copy into them.
+        m_geometry = geometry;
+        std::clog << "[FrameSource]: Frames in " << m_name << " are now " << geometry.m_width << "x" << geometry.m_height << " (" << SIZE << " bytes)." << std::endl;
+    }
+    return true;
+}
+
+void FrameSource::recycle(cv::Mat&& image) {
+    std::lock_guard<std::mutex> lck(m_mutex);
+    if (!image.empty() && (m_pool.size() < MAX_POOLED_IMAGES)) {
+        m_pool.push_back(std::move(image));
+    }
+}
+
+cv::Mat FrameSource::acquire() {
+    std::lock_guard<std::mutex> lck(m_mutex);
+    if (m_pool.empty()) {
+        return cv::Mat();
+    }
+    cv::Mat image { std::move(m_pool.back()) };
+    m_pool.pop_back();
+    return image;
+}
+
+void FrameSource::captureFrameSharedMemory() {
+    std::vector<char> buffer(m_frames.size());
+    FrameInfo info;
+    while (m_running.load(std::memory_order_relaxed)) {
+        // Wait for a frame newer than the last one; copying it takes no lock
+        // and the producer keeps writing into the next slot meanwhile. Wake up
+        // regularly to notice being stopped.
+        const uint64_t LAST_FRAME_NUMBER { info.m_frameNumber };
+        if (!m_frames.waitForFrame(LAST_FRAME_NUMBER, std::chrono::milliseconds(100), m_spins) || !m_frames.copyFrame(buffer.data(), buffer.size(), info)) {
+            continue;
+        }
+        if ((0 < LAST_FRAME_NUMBER) && (info.m_frameNumber > LAST_FRAME_NUMBER + 1)) {
+            m_numberOfDroppedFrames.fetch_add(info.m_frameNumber - LAST_FRAME_NUMBER - 1, std::memory_order_relaxed);
+        }
+        Frame frame;
+        frame.m_source = m_index;
+        frame.m_frameNumber = info.m_frameNumber;
+        frame.m_sampleTimeStamp = info.m_sampleTimeStamp;
+        const uint64_t SIZE { frameSize(info.m_pixelFormat, info.m_width, info.m_height) };
+        if ((0 < SIZE) && (SIZE <= info.m_size)) {
+            // copyTo() only reallocates a pooled image if the geometry changed.
+            frame.m_pixelFormat = info.m_pixelFormat;
+            frame.m_image = acquire();
+            wrap(info.m_pixelFormat, info.m_width, info.m_height, buffer.data()).copyTo(frame.m_image);
+        }
+        m_lastFrameTime.store(std::chrono::steady_clock::now().time_since_epoch().count(), std::memory_order_relaxed);
+        m_delegate(std::move(frame));
+    }
+}
+
+void FrameSource::captureSharedMemory() {
+    uint64_t frameNumber { 0 };
+    while (m_running.load(std::memory_order_relaxed)) {
+        // Wait for a notification of a new frame.
+        m_sharedMemory->wait();
+        if (!m_running.load(std::memory_order_relaxed)) {
+            break;
+        }
+
+        Frame frame;
+        frame.m_source = m_index;
+        frame.m_frameNumber = ++frameNumber;
+        Geometry geometry {};
+        {
+            std::lock_guard<std::mutex> lck(m_mutex);
+            geometry = m_geometry;
+        }
+        // Without a known geometry, the frame only carries its time stamp.
+        const bool KNOWN { (0 < geometry.m_width) && (0 < geometry.m_height) };
+        if (KNOWN) {
+            frame.m_pixelFormat = geometry.m_pixelFormat;
+            frame.m_image = acquire();
+        }
+        m_sharedMemory->lock();
+        if (KNOWN) {
+            // Copy the pixels from the shared memory into our own data structure.
+            wrap(geometry.m_pixelFormat, geometry.m_width, geometry.m_height, m_sharedMemory->data()).copyTo(frame.m_image);
+        }
+        frame.m_sampleTimeStamp = cluon::time::toMicroseconds(m_sharedMemory->getTimeStamp().second) * 1000;
+        m_sharedMemory->unlock();
+        m_lastFrameTime.store(std::chrono::steady_clock::now().time_since_epoch().count(), std::memory_order_relaxed);
+        m_delegate(std::move(frame));
+    }
+    m_captureStopped.store(true);
+}
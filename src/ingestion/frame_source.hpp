@@ -0,0 +1,109 @@
+// One camera: attaches to a shared memory area (FrameSharedMemory, or
+// cluon::SharedMemory with a given geometry) and captures its frames in an own
+// thread, handing each copied frame to a delegate. cluon::SharedMemory areas, as
+// written by the h264decoder, are read as before: wait(), copy under the lock,
+// and the area's time stamp; FrameSharedMemory is opt-in for producers built
+// on it. Frame images come from a
+// pool that consumers refill with recycle(), so steady-state capture does not
+// allocate.
+#ifndef FRAME_SOURCE_H
+#define FRAME_SOURCE_H
+
+#include "cluon-complete.hpp"
+#include <shared_memory/frame_shared_memory.hpp>
+#include <opencv2/core/core.hpp>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+struct Frame {
+    // Index of the FrameSource the frame came from.
+    std::size_t m_source { 0 };
+    uint64_t m_frameNumber { 0 };
+    // Sample time stamp in nanoseconds.
+    int64_t m_sampleTimeStamp { 0 };
+    // Layout of m_image: CV_8UC4 or CV_8UC3 for packed formats, CV_8UC1 of
+    // height * 3 / 2 rows for YUV 4:2:0.
+    PixelFormat m_pixelFormat { PixelFormat::UNKNOWN };
+    cv::Mat m_image {};
+};
+
+class FrameSource {
+   private:
+    FrameSource(const FrameSource&) = delete;
+    FrameSource(FrameSource&&) = delete;
+    FrameSource& operator=(const FrameSource&) = delete;
+    FrameSource& operator=(FrameSource&&) = delete;
+
+   public:
+    using Delegate = std::function<void(Frame&&)>;
+
+    // Images kept for reuse at most; further recycled images are freed.
+    static constexpr std::size_t MAX_POOLED_IMAGES { 8 };
+
+    // width, height and format are only used for cluon::SharedMemory areas,
+    // whose geometry is not known otherwise; 0 until reconfigure() sets them.
+    // The delegate is called from the capture thread.
+    FrameSource(std::size_t index, const std::string& name, uint32_t width, uint32_t height, PixelFormat format, const FrameSharedMemoryOptions& placement, uint32_t spins, Delegate delegate);
+    ~FrameSource();
+
+    bool valid() const noexcept;
+    const std::string& name() const noexcept;
+    uint32_t size() const noexcept;
+    // Frames the producer published that were never captured.
+    uint64_t numberOfDroppedFrames() const noexcept;
+    // When the last frame was captured; the time of construction before.
+    std::chrono::steady_clock::time_point lastFrameTime() const noexcept;
+
+    // Sets the geometry of a cluon::SharedMemory area from now on, e.g. from an
+    // ImageReadingShared; FrameSharedMemory areas describe each frame in their
+    // header and ignore it. bytesPerPixel selects between 4 byte pixels in the
+    // configured format and BGR; YUV areas keep their format. Returns false if
+    // such frames do not fit the area.
+    bool reconfigure(uint32_t width, uint32_t height, uint32_t bytesPerPixel);
+    // Hands a frame's image back to be filled with a later frame.
+    void recycle(cv::Mat&& image);
+
+   private:
+    void captureFrameSharedMemory();
+    void captureSharedMemory();
+    // A pooled image, or an empty one to be allocated by the first copy into it.
+    cv::Mat acquire();
+
+   private:
+    struct Geometry {
+        uint32_t m_width;
+        uint32_t m_height;
+        PixelFormat m_pixelFormat;
+    };
+
+    bool setGeometry(const Geometry& geometry);
+
+    const std::size_t m_index;
+    const PixelFormat m_pixelFormat;
+    const uint32_t m_spins;
+    Delegate m_delegate;
+    FrameSharedMemory m_frames;
+    std::unique_ptr<cluon::SharedMemory> m_sharedMemory;
+    std::string m_name;
+
+    std::mutex m_mutex;
+    Geometry m_geometry;
+    std::vector<cv::Mat> m_pool;
+
+    std::atomic<bool> m_running;
+    // Set by captureSharedMemory() when it returns.
+    std::atomic<bool> m_captureStopped;
+    std::atomic<uint64_t> m_numberOfDroppedFrames;
+    std::atomic<std::chrono::steady_clock::rep> m_lastFrameTime;
+    std::thread m_captureThread;
+};
+
+#endif
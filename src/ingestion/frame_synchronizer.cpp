@@ -0,0 +1,72 @@
+#include "frame_synchronizer.hpp"
+#include <cstdlib>
+
+FrameSynchronizer::FrameSynchronizer(std::size_t numberOfSources, std::chrono::nanoseconds tolerance, std::size_t depth)
+    : m_tolerance(tolerance.count())
+    , m_depth((0 < depth) ? depth : 1)
+    , m_mutex()
+    , m_condition()
+    , m_queues(numberOfSources)
+    , m_numberOfUnmatchedFrames(0) {}
+
+void FrameSynchronizer::add(Frame&& frame) {
+    {
+        std::lock_guard<std::mutex> lck(m_mutex);
+        if (frame.m_source >= m_queues.size()) {
+            return;
+        }
+        auto& queue = m_queues[frame.m_source];
+        queue.push_back(std::move(frame));
+        if (queue.size() > m_depth) {
+            queue.pop_front();
+            m_numberOfUnmatchedFrames++;
+        }
+    }
+    m_condition.notify_one();
+}
+
+bool FrameSynchronizer::waitForFrames(std::vector<Frame>& frames, std::chrono::nanoseconds timeout) {
+    std::unique_lock<std::mutex> lck(m_mutex);
+    return m_condition.wait_for(lck, timeout, [this, &frames]() { return match(frames); });
+}
+
+uint64_t FrameSynchronizer::numberOfUnmatchedFrames() const noexcept {
+    std::lock_guard<std::mutex> lck(m_mutex);
+    return m_numberOfUnmatchedFrames;
+}
+
+bool FrameSynchronizer::match(std::vector<Frame>& frames) {
+    if (m_queues.empty()) {
+        return false;
+    }
+    // Try the first source's frames from the newest; for every other source,
+    // pick its frame closest in time.
+    std::vector<std::size_t> picks(m_queues.size(), 0);
+    for (std::size_t candidate { m_queues[0].size() }; candidate-- > 0;) {
+        const int64_t REFERENCE { m_queues[0][candidate].m_sampleTimeStamp };
+        picks[0] = candidate;
+        bool complete { true };
+        for (std::size_t s { 1 }; complete && (s < m_queues.size()); s++) {
+            int64_t closest { -1 };
+            for (std::size_t i { 0 }; i < m_queues[s].size(); i++) {
+                const int64_t DISTANCE { std::llabs(m_queues[s][i].m_sampleTimeStamp - REFERENCE) };
+                if ((DISTANCE <= m_tolerance) && ((0 > closest) || (DISTANCE < std::llabs(m_queues[s][static_cast<std::size_t>(closest)].m_sampleTimeStamp - REFERENCE)))) {
+                    closest = static_cast<int64_t>(i);
+                }
+            }
+            complete = (0 <= closest);
+            picks[s] = static_cast<std::size_t>(closest);
+        }
+        if (complete) {
+            frames.clear();
+            for (std::size_t s { 0 }; s < m_queues.size(); s++) {
+                frames.push_back(std::move(m_queues[s][picks[s]]));
+                // Frames before the picked one can no longer be part of a newer set.
+                m_numberOfUnmatchedFrames += picks[s];
+                m_queues[s].erase(m_queues[s].begin(), m_queues[s].begin() + static_cast<std::ptrdiff_t>(picks[s]) + 1);
+            }
+            return true;
+        }
+    }
+    return false;
+}
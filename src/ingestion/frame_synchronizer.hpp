@@ -0,0 +1,49 @@
+// Matches frames from several FrameSources by sample time stamp: a set holds one
+// frame per source, all within a tolerance of each other. The newest complete
+// set wins; older frames are dropped so that processing never falls behind.
+#ifndef FRAME_SYNCHRONIZER_H
+#define FRAME_SYNCHRONIZER_H
+
+#include <ingestion/frame_source.hpp>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <vector>
+
+class FrameSynchronizer {
+   private:
+    FrameSynchronizer(const FrameSynchronizer&) = delete;
+    FrameSynchronizer(FrameSynchronizer&&) = delete;
+    FrameSynchronizer& operator=(const FrameSynchronizer&) = delete;
+    FrameSynchronizer& operator=(FrameSynchronizer&&) = delete;
+
+   public:
+    // depth is the number of frames kept per source while waiting for a match.
+    FrameSynchronizer(std::size_t numberOfSources, std::chrono::nanoseconds tolerance, std::size_t depth = 4);
+
+    // Called from the capture threads.
+    void add(Frame&& frame);
+
+    // Waits for the next matched set, ordered by source; false on timeout.
+    bool waitForFrames(std::vector<Frame>& frames, std::chrono::nanoseconds timeout);
+
+    // Frames dropped without being part of a set.
+    uint64_t numberOfUnmatchedFrames() const noexcept;
+
+   private:
+    bool match(std::vector<Frame>& frames);
+
+   private:
+    const int64_t m_tolerance;
+    const std::size_t m_depth;
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_condition;
+    std::vector<std::deque<Frame>> m_queues;
+    uint64_t m_numberOfUnmatchedFrames;
+};
+
+#endif
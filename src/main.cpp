@@ -22,27 +22,30 @@
 #include "opendlv-standard-message-set.hpp"
 
 // Include the GUI and image processing header files from OpenCV
+#include <algorithm>
+#include <chrono>
 #include <cmath>
 #include <cone_detection/cone_detector.hpp>
+#include <od4/od4_receiver.hpp>
+#include <od4/prediction_publisher.hpp>
+#include <prediction/frame_processor.hpp>
+#include <replay/frame_replay.hpp>
+#include <replay/recording_player.hpp>
+#include <replay/replay_clock.hpp>
+#include <ingestion/frame_source.hpp>
+#include <ingestion/frame_synchronizer.hpp>
+#include <shared_memory/frame_shared_memory.hpp>
 #include <fstream>
+#include <memory>
 #include <opencv2/highgui/highgui.hpp>
 #include <opencv2/imgproc/imgproc.hpp>
+#include <sstream>
 #include <vector>
 #include "main.hpp"
 #include <string>
 
 
 
-double predict(double speed) {
-    std::vector<double> coefficients = {0.00000000e+00, 3.96583242e-03, -1.05373477e-04, -3.17407267e-07, 4.68268257e-08, -1.49984238e-10, -5.54462195e-12, 3.47391935e-14};
-    double intercept = 0.05159669059756054;
-    double prediction = intercept;
-    for (int i = 0; i < coefficients.size(); i++) {
-        prediction += coefficients[i] * std::pow(speed, i);
-    }
-    return prediction;
-}
-
 int32_t main(int32_t argc, char** argv) {
     int totalFrames = 0;
     int total_correct = 0;
@@ -51,66 +54,94 @@ int32_t main(int32_t argc, char** argv) {
     int32_t retCode { 1 };
     // Parse the command line parameters as we require the user to specify some mandatory information on startup.
     auto commandlineArguments = cluon::getCommandlineArguments(argc, argv);
-    if ((0 == commandlineArguments.count("cid")) || (0 == commandlineArguments.count("name")) || (0 == commandlineArguments.count("width")) || (0 == commandlineArguments.count("height"))) {
+    const bool REPLAYING { 0 != commandlineArguments.count("replay") };
+    if (!REPLAYING && ((0 == commandlineArguments.count("cid")) || (0 == commandlineArguments.count("name")))) {
         std::cerr << argv[0] << " attaches to a shared memory area containing an ARGB image." << std::endl;
-        std::cerr << "Usage:   " << argv[0] << " --cid=<OD4 session> --name=<name of shared memory area> [--verbose]" << std::endl;
+        std::cerr << "Usage:   " << argv[0] << " --cid=<OD4 session> --name=<name of shared memory area> [--width=<w> --height=<h>] [--format=<pixel format>] [--id=<sender stamp>] [--rate=<Hz>] [--timeout=<s>] [--spin=<n>] [--numa=<node>|local] [--sync=<ms>] [--verbose]" << std::endl;
+        std::cerr << "         " << argv[0] << " --replay=<recording.rec> [--speed=<factor>|max|step] [--replay-source=mmap|read-ahead]" << std::endl;
         std::cerr << "         --cid:    CID of the OD4Session to send and receive messages" << std::endl;
-        std::cerr << "         --name:   name of the shared memory area to attach" << std::endl;
-        std::cerr << "         --width:  width of the frame" << std::endl;
-        std::cerr << "         --height: height of the frame" << std::endl;
+        std::cerr << "         --name:   name of the shared memory area to attach; several cameras as comma-separated list" << std::endl;
+        std::cerr << "         --width:  width of the frame; one per camera or one for all (default: from ImageReadingShared)" << std::endl;
+        std::cerr << "         --height: height of the frame; one per camera or one for all (default: from ImageReadingShared)" << std::endl;
+        std::cerr << "         --format: layout of the frames in memory, one of bgra, argb, bgr, i420 or nv12; one per camera or one for all (default: bgra)" << std::endl;
+        std::cerr << "         --sync:   maximum difference in ms between the sample times of matched frames from several cameras (default: 20)" << std::endl;
+        std::cerr << "         --id:     sender stamp of the published GroundSteeringRequest (default: 2)" << std::endl;
+        std::cerr << "         --rate:   maximum publishing rate in Hz (default: 20)" << std::endl;
+        std::cerr << "         --timeout: exit with an error when no frame arrived for that many seconds (default: wait forever)" << std::endl;
+        std::cerr << "         --spin:   number of polls for the next frame before sleeping; FrameSharedMemory areas only (default: 0)" << std::endl;
+        std::cerr << "         --numa:   bind the frames to a NUMA node, 'local' for the node this process starts on; FrameSharedMemory areas only" << std::endl;
+        std::cerr << "         --replay: run headless on the frames of a recording instead of the shared memory area; nothing is sent to the OD4 session" << std::endl;
+        std::cerr << "         --speed:  replay speed as factor of real time, 'max' for as fast as possible, or 'step' to advance one frame per line on stdin (default: 1)" << std::endl;
+        std::cerr << "         --replay-source: read the recording through mmap or with io_uring read-ahead for cold storage (default: mmap)" << std::endl;
         std::cerr << "Example: " << argv[0] << " --cid=253 --name=img --width=640 --height=480 --verbose" << std::endl;
+        std::cerr << "         " << argv[0] << " --cid=253 --name=left,right --width=1280 --height=720" << std::endl;
     } else {
         // Extract the values from the command line parameters
         const std::string NAME { commandlineArguments["name"] };
-        const uint32_t WIDTH { static_cast<uint32_t>(std::stoi(commandlineArguments["width"])) };
-        const uint32_t HEIGHT { static_cast<uint32_t>(std::stoi(commandlineArguments["height"])) };
         const bool VERBOSE { commandlineArguments.count("verbose") != 0 };
+        const uint32_t ID { (commandlineArguments.count("id") != 0) ? static_cast<uint32_t>(std::stoi(commandlineArguments["id"])) : 2 };
+        const float RATE { (commandlineArguments.count("rate") != 0) ? std::stof(commandlineArguments["rate"]) : 20.0f };
+        const float TIMEOUT { (commandlineArguments.count("timeout") != 0) ? std::stof(commandlineArguments["timeout"]) : 0.0f };
+        const uint32_t SPINS { (commandlineArguments.count("spin") != 0) ? static_cast<uint32_t>(std::stoi(commandlineArguments["spin"])) : 0 };
+        // Set when no frame arrived within --timeout or a camera cannot be used.
+        bool failed { false };
 
-        // Attach to the shared memory.
-        std::unique_ptr<cluon::SharedMemory> sharedMemory { new cluon::SharedMemory { NAME } };
-        if (sharedMemory && sharedMemory->valid()) {
-            std::clog << argv[0] << ": Attached to shared memory '" << sharedMemory->name() << " (" << sharedMemory->size() << " bytes)." << std::endl;
+        ReplayClock::Mode replayMode { ReplayClock::Mode::REALTIME };
+        float replaySpeed { 1.0f };
+        if ((0 != commandlineArguments.count("speed")) && !ReplayClock::parse(commandlineArguments["speed"], replayMode, replaySpeed)) {
+            std::cerr << argv[0] << ": Invalid --speed '" << commandlineArguments["speed"] << "'; replaying in real time." << std::endl;
+        }
+        RecordingPlayer::Source replaySource { RecordingPlayer::Source::MAPPED };
+        if ((0 != commandlineArguments.count("replay-source")) && !RecordingPlayer::parse(commandlineArguments["replay-source"], replaySource)) {
+            std::cerr << argv[0] << ": Invalid --replay-source '" << commandlineArguments["replay-source"] << "'; reading through mmap." << std::endl;
+        }
 
-            // Interface to a running OpenDaVINCI session where network messages are exchanged.
-            // The instance od4 allows you to send and receive messages.
-            cluon::OD4Session od4 { static_cast<uint16_t>(std::stoi(commandlineArguments["cid"])) };
+        {
+            // Predictions are sent from their own thread, rate limited to RATE. A
+            // replay must not steer the vehicles on the live OD4 session.
+            std::unique_ptr<PredictionPublisher> publisher;
+            if (!REPLAYING) {
+                publisher.reset(new PredictionPublisher { static_cast<uint16_t>(std::stoi(commandlineArguments["cid"])), ID, RATE });
+            }
+
+            auto split = [](const std::string &list) {
+                std::vector<std::string> items;
+                std::stringstream stream { list };
+                for (std::string item; std::getline(stream, item, ',');) {
+                    items.push_back(item);
+                }
+                return items;
+            };
+            const std::vector<std::string> NAMES { split(NAME) };
+
+            // Predictions and cones of each frame come from the same FrameProcessor
+            // that replay-diff uses; a replay has a single camera. Cones are only
+            // drawn into the displayed frames as predictions do not use them yet.
+            ConeDetectorOptions detection;
+            detection.m_output = VERBOSE ? ConeDetectorOptions::Output::ANNOTATED : ConeDetectorOptions::Output::RESULT;
+            FrameProcessor processor { REPLAYING ? 1 : NAMES.size(), detection };
 
             opendlv::proxy::GroundSteeringRequest gsr;
             std::mutex gsrMutex;
-            opendlv::proxy::AngularVelocityReading vr;
-            std::mutex vMutex;
-            auto onGroundSteeringRequest = [&gsr, &gsrMutex](cluon::data::Envelope&& env) {
+            auto onGroundSteeringRequest = [&gsr, &gsrMutex, ID](cluon::data::Envelope&& env) {
+                // Ignore our own published predictions.
+                if (env.senderStamp() == ID) {
+                    return;
+                }
                 std::lock_guard<std::mutex> lck(gsrMutex);
                 gsr = cluon::extractMessage<opendlv::proxy::GroundSteeringRequest>(std::move(env));
                 //std::cout << "onGroundSteeringRequest triggered. groundSteering = " << gsr.groundSteering() << std::endl;
             };
-            od4.dataTrigger(opendlv::proxy::GroundSteeringRequest::ID(), onGroundSteeringRequest);
-            auto onVelocityRequest = [&vr, &vMutex](cluon::data::Envelope&& env) {
-                std::lock_guard<std::mutex> lck(vMutex);
-                vr = cluon::extractMessage<opendlv::proxy::AngularVelocityReading>(std::move(env));
-                //std::cout << "onVelocityRequest triggered. angularVelocityZ = " << vr.angularVelocityZ() << std::endl;
+            auto onVelocityRequest = [&processor](cluon::data::Envelope&& env) {
+                processor.setAngularVelocityZ(cluon::extractMessage<opendlv::proxy::AngularVelocityReading>(std::move(env)).angularVelocityZ());
+                //std::cout << "onVelocityRequest triggered. angularVelocityZ = " << processor.angularVelocityZ() << std::endl;
             };
-            od4.dataTrigger(opendlv::proxy::GroundSteeringRequest::ID(), onGroundSteeringRequest);
-            od4.dataTrigger(opendlv::proxy::AngularVelocityReading::ID(), onVelocityRequest);
-            // Endless loop; end the program by pressing Ctrl-C.
-            while (od4.isRunning()) {
-                // OpenCV data structure to hold an image.
-                cv::Mat img;
-                // Wait for a notification of a new frame.
-                sharedMemory->wait();
-
-                // Lock the shared memory.
-                sharedMemory->lock();
-
-                {
-                    // Copy the pixels from the shared memory into our own data structure.
-                    cv::Mat wrapped(HEIGHT, WIDTH, CV_8UC4, sharedMemory->data());
-                    img = wrapped.clone();
-                }
 
-                auto sampleTimePoint = sharedMemory->getTimeStamp(); // Get the TimeStamp from shared memory
-                int64_t timeMs = cluon::time::toMicroseconds(sampleTimePoint.second); // Get the time in microseconds from the time stamp
-                double prediction = predict(vr.angularVelocityZ());
+            // Processing of one set of frames; the same for live frames and replayed ones.
+            auto onFrame = [&](const cluon::data::TimeStamp& sampleTimeStamp, const std::vector<FrameView>& views) -> const FrameResult& {
+                int64_t timeMs = cluon::time::toMicroseconds(sampleTimeStamp); // Get the time in microseconds from the time stamp
+                const FrameResult& result = processor.process(views);
+                double prediction = result.m_prediction;
                 if (gsr.groundSteering() != 0 && gsr.groundSteering() != -0) {
                     totalFrames++;
 
@@ -133,30 +164,177 @@ int32_t main(int32_t argc, char** argv) {
                     
                 }
                 std::cout << "group_02;" << timeMs << ";" << prediction << std::endl;
-                
-    
+                if (publisher) {
+                    publisher->publish(static_cast<float>(prediction), sampleTimeStamp);
+                }
+                return result;
+            };
 
-                sharedMemory->unlock();
+            if (REPLAYING) {
+                // Frames are the recorded ImageReadings; the inputs in between are
+                // handed to the same delegates as live, in recorded order.
+                FrameReplay replay { commandlineArguments["replay"], { EnvelopeFilter { opendlv::proxy::GroundSteeringRequest::ID() }, EnvelopeFilter { opendlv::proxy::AngularVelocityReading::ID() } }, replaySource };
+                ReplayClock clock { replayMode, replaySpeed };
+                std::vector<FrameView> views(1);
+                auto onReplayedFrame = [&](const cluon::data::TimeStamp& sampleTimeStamp, const cv::Mat& image) {
+                    std::string line;
+                    if (ReplayClock::Mode::STEP == replayMode) {
+                        // Each line on stdin advances one frame.
+                        if (!std::getline(std::cin, line)) {
+                            return false;
+                        }
+                        clock.step();
+                    }
+                    if (!clock.waitUntil(cluon::time::toMicroseconds(sampleTimeStamp))) {
+                        return false;
+                    }
+                    views[0] = FrameView { PixelFormat::BGR, image };
+                    onFrame(sampleTimeStamp, views);
+                    return true;
+                };
+                auto onReplayedEnvelope = [&](cluon::data::Envelope&& env) {
+                    if (opendlv::proxy::GroundSteeringRequest::ID() == env.dataType()) {
+                        onGroundSteeringRequest(std::move(env));
+                    } else {
+                        onVelocityRequest(std::move(env));
+                    }
+                };
+                if (!replay.valid() || !replay.run(onReplayedFrame, onReplayedEnvelope)) {
+                    std::cerr << argv[0] << ": Failed to replay '" << commandlineArguments["replay"] << "'." << std::endl;
+                    failed = true;
+                }
+            } else {
+                // One capture thread per camera; frames are processed as sets matched
+                // by sample time stamp, in this thread.
+                FrameSharedMemoryOptions placement;
+                placement.m_prefault = true;
+                if (0 != commandlineArguments.count("numa")) {
+                    placement.m_numaNode = ("local" == commandlineArguments["numa"]) ? FrameSharedMemoryOptions::LOCAL_NUMA_NODE : std::stoi(commandlineArguments["numa"]);
+                }
+                if (NAMES.empty() || (NAMES.end() != std::find(NAMES.begin(), NAMES.end(), std::string()))) {
+                    std::cerr << argv[0] << ": Invalid --name list '" << NAME << "'." << std::endl;
+                    failed = true;
+                }
+                const std::vector<std::string> WIDTHS { split(commandlineArguments["width"]) };
+                const std::vector<std::string> HEIGHTS { split(commandlineArguments["height"]) };
+                const std::vector<std::string> FORMATS { split(commandlineArguments["format"]) };
+                const float SYNC { (commandlineArguments.count("sync") != 0) ? std::stof(commandlineArguments["sync"]) : 20.0f };
+                FrameSynchronizer synchronizer { NAMES.size(), std::chrono::microseconds(static_cast<int64_t>(SYNC * 1000.0f)) };
+                std::vector<std::unique_ptr<FrameSource>> sources;
+                for (std::size_t i { 0 }; !failed && (i < NAMES.size()); i++) {
+                    // A single --width/--height applies to all cameras; without them, the
+                    // geometry is taken from the producer's ImageReadingShared.
+                    const uint32_t WIDTH { WIDTHS.empty() ? 0 : static_cast<uint32_t>(std::stoi(WIDTHS[(i < WIDTHS.size()) ? i : WIDTHS.size() - 1])) };
+                    const uint32_t HEIGHT { HEIGHTS.empty() ? 0 : static_cast<uint32_t>(std::stoi(HEIGHTS[(i < HEIGHTS.size()) ? i : HEIGHTS.size() - 1])) };
+                    // Only areas without a FrameSharedMemory header need the format.
+                    const PixelFormat FORMAT { FORMATS.empty() ? PixelFormat::BGRA : pixelFormat(FORMATS[(i < FORMATS.size()) ? i : FORMATS.size() - 1]) };
+                    if (PixelFormat::UNKNOWN == FORMAT) {
+                        std::cerr << argv[0] << ": Unknown --format for '" << NAMES[i] << "'." << std::endl;
+                        sources.clear();
+                        failed = true;
+                        break;
+                    }
+                    sources.emplace_back(new FrameSource { i, NAMES[i], WIDTH, HEIGHT, FORMAT, placement, SPINS, [&synchronizer](Frame&& frame) { synchronizer.add(std::move(frame)); } });
+                    if (!sources.back()->valid()) {
+                        std::cerr << argv[0] << ": Failed to attach to shared memory '" << NAMES[i] << "'." << std::endl;
+                        sources.clear();
+                        failed = true;
+                        break;
+                    }
+                    std::clog << argv[0] << ": Attached to shared memory '" << sources.back()->name() << " (" << sources.back()->size() << " bytes)." << std::endl;
+                }
+                if (!sources.empty()) {
+                    std::vector<Frame> frames;
+                    std::vector<FrameView> views;
+                    auto lastFrameTime { std::chrono::steady_clock::now() };
 
-                // Display image on your screen.
-                if (VERBOSE) {
+                    // Interface to a running OpenDaVINCI session where network messages are received.
+                    // Our own predictions are filtered out by the publisher's local port.
+                    Od4Receiver od4 { static_cast<uint16_t>(std::stoi(commandlineArguments["cid"])), publisher->sendFromPort() };
+                    // onGroundSteeringRequest waits for gsrMutex, which the frame loop holds
+                    // while printing; it runs on its own queue so the receiver keeps draining
+                    // the socket meanwhile.
+                    od4.dataTrigger(opendlv::proxy::GroundSteeringRequest::ID(), onGroundSteeringRequest, Od4Receiver::Dispatch::QUEUED);
+                    od4.dataTrigger(opendlv::proxy::AngularVelocityReading::ID(), onVelocityRequest);
+                    // Producers announce the geometry of their areas; follow it when it changes.
+                    // Reconfiguring locks the sources and logs, so it is queued as well.
+                    od4.dataTrigger(opendlv::proxy::ImageReadingShared::ID(), [&sources](cluon::data::Envelope&& env) {
+                        auto irs = cluon::extractMessage<opendlv::proxy::ImageReadingShared>(std::move(env));
+                        // Areas are named with a platform-specific prefix such as / or /tmp/.
+                        auto baseName = [](const std::string& name) { return name.substr(name.find_last_of('/') + 1); };
+                        for (auto& source : sources) {
+                            if (baseName(source->name()) == baseName(irs.name())) {
+                                source->reconfigure(irs.width(), irs.height(), irs.bytesPerPixel());
+                            }
+                        }
+                    }, Od4Receiver::Dispatch::QUEUED);
+                    // Endless loop; end the program by pressing Ctrl-C.
+                    while (od4.isRunning()) {
+                        // Wake up regularly to notice a stopped OD4 session or a dead producer.
+                        if (!synchronizer.waitForFrames(frames, std::chrono::milliseconds(100))) {
+                            const auto NOW { std::chrono::steady_clock::now() };
+                            if ((0.0f < TIMEOUT) && (NOW - lastFrameTime > std::chrono::duration<float>(TIMEOUT))) {
+                                // Name the cameras that stopped; if none did, their frames never matched.
+                                std::string stalled;
+                                for (const auto& source : sources) {
+                                    if (NOW - source->lastFrameTime() > std::chrono::duration<float>(TIMEOUT)) {
+                                        stalled += (stalled.empty() ? "" : ",") + source->name();
+                                    }
+                                }
+                                if (stalled.empty()) {
+                                    std::cerr << argv[0] << ": No frames within " << SYNC << "ms of each other in '" << NAME << "' for " << TIMEOUT << "s; exiting." << std::endl;
+                                } else {
+                                    std::cerr << argv[0] << ": No frame in '" << stalled << "' for " << TIMEOUT << "s; exiting." << std::endl;
+                                }
+                                failed = true;
+                                break;
+                            }
+                            continue;
+                        }
+                        lastFrameTime = std::chrono::steady_clock::now();
 
-                    std::string text = "Speed: " + std::to_string(vr.angularVelocityZ()) + " Predicted angle: " + std::to_string(prediction);
-                    cv::Point textPosition(10, 30);  
+                        // The first camera's frame defines the sample time.
+                        views.clear();
+                        for (const Frame& frame : frames) {
+                            views.push_back(FrameView { frame.m_pixelFormat, frame.m_image });
+                        }
+                        const FrameResult& result = onFrame(cluon::time::fromMicroseconds(frames[0].m_sampleTimeStamp / 1000), views);
 
-                    // display the text on the image
-                    int fontFace = cv::FONT_HERSHEY_SIMPLEX;
-                    double fontScale = 0.5;
-                    cv::Scalar textColor(0, 0, 255);  // red text
-                    cv::putText(img, text, textPosition, fontFace, fontScale, textColor);
+                        // Display image on your screen.
+                        for (std::size_t i { 0 }; VERBOSE && (i < frames.size()); i++) {
+                            cv::Mat img = frames[i].m_image;
+                            if (img.empty()) {
+                                continue;
+                            }
+                            const ConeResult& cones = result.m_cones[i];
+                            // Of YUV 4:2:0 frames, the luma plane is shown.
+                            if ((PixelFormat::I420 == frames[i].m_pixelFormat) || (PixelFormat::NV12 == frames[i].m_pixelFormat)) {
+                                img = img(cv::Rect(0, 0, img.cols, img.rows * 2 / 3));
+                            }
 
-                    // show the image
-                    cv::imshow(sharedMemory->name().c_str(), img);
-                    cv::waitKey(1);
+                            std::string text = "Speed: " + std::to_string(processor.angularVelocityZ()) + " Predicted angle: " + std::to_string(result.m_prediction) + " Dropped: " + std::to_string(sources[i]->numberOfDroppedFrames()) + " Cones: " + std::to_string(cones.m_left.x) + "/" + std::to_string(cones.m_right.x);
+                            cv::Point textPosition(10, 30);  
+
+                            // display the text on the image
+                            int fontFace = cv::FONT_HERSHEY_SIMPLEX;
+                            double fontScale = 0.5;
+                            cv::Scalar textColor(0, 0, 255);  // red text
+                            cv::putText(img, text, textPosition, fontFace, fontScale, textColor);
+
+                            // show the image
+                            cv::imshow(sources[i]->name().c_str(), img);
+                        }
+                        if (VERBOSE) {
+                            cv::waitKey(1);
+                        }
+                        for (Frame& frame : frames) {
+                            sources[frame.m_source]->recycle(std::move(frame.m_image));
+                        }
+                    }
                 }
             }
         }
-        retCode = 0;
+        retCode = failed ? 1 : 0;
     }
 
     return retCode;
@@ -1,3 +1,2 @@
-
 //function that returns the predicted ground steering angle
-double predict(double speed);
+#include <prediction/predict.hpp>
@@ -0,0 +1,154 @@
+#include "envelope_encoder.hpp"
+#include <cstring>
+
+ProtoEncoder::ProtoEncoder(char* cursor) noexcept
+    : m_cursor(cursor) {
+}
+
+std::size_t ProtoEncoder::size() const noexcept {
+    return m_size;
+}
+
+char* ProtoEncoder::cursor() const noexcept {
+    return m_cursor;
+}
+
+void ProtoEncoder::preVisit(int32_t /*id*/, const std::string& /*shortName*/, const std::string& /*longName*/) noexcept {
+}
+
+void ProtoEncoder::postVisit() noexcept {
+}
+
+void ProtoEncoder::visit(uint32_t id, std::string&& /*typeName*/, std::string&& /*name*/, bool& v) noexcept {
+    putKey(id, cluon::ProtoConstants::VARINT);
+    putVarInt(v ? 1u : 0u);
+}
+
+void ProtoEncoder::visit(uint32_t id, std::string&& /*typeName*/, std::string&& /*name*/, char& v) noexcept {
+    putKey(id, cluon::ProtoConstants::VARINT);
+    putVarInt(static_cast<uint8_t>(v));
+}
+
+void ProtoEncoder::visit(uint32_t id, std::string&& /*typeName*/, std::string&& /*name*/, int8_t& v) noexcept {
+    putKey(id, cluon::ProtoConstants::VARINT);
+    putVarInt(static_cast<uint8_t>((v << 1) ^ (v >> 7)));
+}
+
+void ProtoEncoder::visit(uint32_t id, std::string&& /*typeName*/, std::string&& /*name*/, uint8_t& v) noexcept {
+    putKey(id, cluon::ProtoConstants::VARINT);
+    putVarInt(v);
+}
+
+void ProtoEncoder::visit(uint32_t id, std::string&& /*typeName*/, std::string&& /*name*/, int16_t& v) noexcept {
+    putKey(id, cluon::ProtoConstants::VARINT);
+    putVarInt(static_cast<uint16_t>((v << 1) ^ (v >> 15)));
+}
+
+void ProtoEncoder::visit(uint32_t id, std::string&& /*typeName*/, std::string&& /*name*/, uint16_t& v) noexcept {
+    putKey(id, cluon::ProtoConstants::VARINT);
+    putVarInt(v);
+}
+
+void ProtoEncoder::visit(uint32_t id, std::string&& /*typeName*/, std::string&& /*name*/, int32_t& v) noexcept {
+    putKey(id, cluon::ProtoConstants::VARINT);
+    putVarInt(static_cast<uint32_t>((v << 1) ^ (v >> 31)));
+}
+
+void ProtoEncoder::visit(uint32_t id, std::string&& /*typeName*/, std::string&& /*name*/, uint32_t& v) noexcept {
+    putKey(id, cluon::ProtoConstants::VARINT);
+    putVarInt(v);
+}
+
+void ProtoEncoder::visit(uint32_t id, std::string&& /*typeName*/, std::string&& /*name*/, int64_t& v) noexcept {
+    putKey(id, cluon::ProtoConstants::VARINT);
+    putVarInt(static_cast<uint64_t>((v << 1) ^ (v >> 63)));
+}
+
+void ProtoEncoder::visit(uint32_t id, std::string&& /*typeName*/, std::string&& /*name*/, uint64_t& v) noexcept {
+    putKey(id, cluon::ProtoConstants::VARINT);
+    putVarInt(v);
+}
+
+void ProtoEncoder::visit(uint32_t id, std::string&& /*typeName*/, std::string&& /*name*/, float& v) noexcept {
+    uint32_t bits { 0 };
+    std::memcpy(&bits, &v, sizeof(float));
+    putKey(id, cluon::ProtoConstants::FOUR_BYTES);
+    putFixed32(bits);
+}
+
+void ProtoEncoder::visit(uint32_t id, std::string&& /*typeName*/, std::string&& /*name*/, double& v) noexcept {
+    uint64_t bits { 0 };
+    std::memcpy(&bits, &v, sizeof(double));
+    putKey(id, cluon::ProtoConstants::EIGHT_BYTES);
+    putFixed64(bits);
+}
+
+void ProtoEncoder::visit(uint32_t id, std::string&& /*typeName*/, std::string&& /*name*/, std::string& v) noexcept {
+    putKey(id, cluon::ProtoConstants::LENGTH_DELIMITED);
+    putVarInt(v.size());
+    putBytes(v.data(), v.size());
+}
+
+void ProtoEncoder::putKey(uint32_t id, cluon::ProtoConstants protoType) noexcept {
+    putVarInt((static_cast<uint64_t>(id) << 0x3) | static_cast<uint8_t>(protoType));
+}
+
+void ProtoEncoder::putVarInt(uint64_t v) noexcept {
+    while (0x7f < v) {
+        if (nullptr != m_cursor) {
+            *m_cursor++ = static_cast<char>((v & 0x7f) | 0x80);
+        }
+        v >>= 7;
+        m_size++;
+    }
+    if (nullptr != m_cursor) {
+        *m_cursor++ = static_cast<char>(v);
+    }
+    m_size++;
+}
+
+void ProtoEncoder::putFixed32(uint32_t v) noexcept {
+    if (nullptr != m_cursor) {
+        v = htole32(v);
+        std::memcpy(m_cursor, &v, sizeof(uint32_t));
+        m_cursor += sizeof(uint32_t);
+    }
+    m_size += sizeof(uint32_t);
+}
+
+void ProtoEncoder::putFixed64(uint64_t v) noexcept {
+    if (nullptr != m_cursor) {
+        v = htole64(v);
+        std::memcpy(m_cursor, &v, sizeof(uint64_t));
+        m_cursor += sizeof(uint64_t);
+    }
+    m_size += sizeof(uint64_t);
+}
+
+void ProtoEncoder::putBytes(const char* data, std::size_t length) noexcept {
+    if ((nullptr != m_cursor) && (0 < length)) {
+        std::memcpy(m_cursor, data, length);
+        m_cursor += length;
+    }
+    m_size += length;
+}
+
+constexpr std::size_t EnvelopeEncoder::OD4_HEADER_SIZE;
+
+EnvelopeEncoder::EnvelopeEncoder(std::size_t initialCapacity)
+    : m_buffer() {
+    m_buffer.reserve(initialCapacity);
+}
+
+const std::string& EnvelopeEncoder::buffer() const noexcept {
+    return m_buffer;
+}
+
+void EnvelopeEncoder::writeHeader(std::size_t length) noexcept {
+    // 0x0D 0xA4 followed by the 24 bit little endian payload length.
+    m_buffer[0] = static_cast<char>(0x0D);
+    m_buffer[1] = static_cast<char>(0xA4);
+    m_buffer[2] = static_cast<char>(length & 0xFF);
+    m_buffer[3] = static_cast<char>((length >> 8) & 0xFF);
+    m_buffer[4] = static_cast<char>((length >> 16) & 0xFF);
+}
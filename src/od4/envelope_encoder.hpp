@@ -0,0 +1,150 @@
+// Allocation-free encoder for OD4 envelopes: sizes a message first, then writes
+// the OD4 header, the Envelope fields and the proto payload into one reusable buffer.
+#ifndef ENVELOPE_ENCODER_H
+#define ENVELOPE_ENCODER_H
+
+#include "cluon-complete.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Proto encoder that either counts bytes (no cursor) or writes them at a cursor
+// into memory that has already been sized by a counting pass.
+class ProtoEncoder {
+   public:
+    ProtoEncoder() = default;
+    explicit ProtoEncoder(char* cursor) noexcept;
+
+    std::size_t size() const noexcept;
+    char* cursor() const noexcept;
+
+    // Encodes all fields of a message; fields are walked by identifier so the
+    // generated accept() does not build its name strings in preVisit.
+    template <typename T>
+    void encodeFields(T& message) noexcept {
+        const uint32_t MAX_FIELD_IDENTIFIER{maxFieldIdentifier<T>()};
+        for (uint32_t id{1}; id <= MAX_FIELD_IDENTIFIER; id++) {
+            message.accept(id, *this);
+        }
+    }
+
+    // Encodes a nested message as length-delimited field.
+    template <typename T>
+    void encodeNested(uint32_t id, T& message) noexcept {
+        ProtoEncoder counter;
+        counter.encodeFields(message);
+        putKey(id, cluon::ProtoConstants::LENGTH_DELIMITED);
+        putVarInt(counter.size());
+        encodeFields(message);
+    }
+
+    // Visitor interface used by the generated message code.
+    void preVisit(int32_t id, const std::string& shortName, const std::string& longName) noexcept;
+    void postVisit() noexcept;
+
+    void visit(uint32_t id, std::string&& typeName, std::string&& name, bool& v) noexcept;
+    void visit(uint32_t id, std::string&& typeName, std::string&& name, char& v) noexcept;
+    void visit(uint32_t id, std::string&& typeName, std::string&& name, int8_t& v) noexcept;
+    void visit(uint32_t id, std::string&& typeName, std::string&& name, uint8_t& v) noexcept;
+    void visit(uint32_t id, std::string&& typeName, std::string&& name, int16_t& v) noexcept;
+    void visit(uint32_t id, std::string&& typeName, std::string&& name, uint16_t& v) noexcept;
+    void visit(uint32_t id, std::string&& typeName, std::string&& name, int32_t& v) noexcept;
+    void visit(uint32_t id, std::string&& typeName, std::string&& name, uint32_t& v) noexcept;
+    void visit(uint32_t id, std::string&& typeName, std::string&& name, int64_t& v) noexcept;
+    void visit(uint32_t id, std::string&& typeName, std::string&& name, uint64_t& v) noexcept;
+    void visit(uint32_t id, std::string&& typeName, std::string&& name, float& v) noexcept;
+    void visit(uint32_t id, std::string&& typeName, std::string&& name, double& v) noexcept;
+    void visit(uint32_t id, std::string&& typeName, std::string&& name, std::string& v) noexcept;
+
+    template <typename T>
+    void visit(uint32_t id, std::string&& /*typeName*/, std::string&& /*name*/, T& value) noexcept {
+        encodeNested(id, value);
+    }
+
+    void putKey(uint32_t id, cluon::ProtoConstants protoType) noexcept;
+    void putVarInt(uint64_t v) noexcept;
+    void putFixed32(uint32_t v) noexcept;
+    void putFixed64(uint64_t v) noexcept;
+    void putBytes(const char* data, std::size_t length) noexcept;
+
+   private:
+    // Highest field identifier of a message type; found once with a full visit.
+    template <typename T>
+    static uint32_t maxFieldIdentifier() noexcept {
+        static const uint32_t MAX_FIELD_IDENTIFIER{[]() {
+            FieldIdentifierProbe probe;
+            T message;
+            message.accept(probe);
+            return probe.m_maxFieldIdentifier;
+        }()};
+        return MAX_FIELD_IDENTIFIER;
+    }
+
+    struct FieldIdentifierProbe {
+        uint32_t m_maxFieldIdentifier{0};
+        void preVisit(int32_t, const std::string&, const std::string&) noexcept {}
+        void postVisit() noexcept {}
+        template <typename T>
+        void visit(uint32_t id, std::string&&, std::string&&, T&) noexcept {
+            m_maxFieldIdentifier = (id > m_maxFieldIdentifier) ? id : m_maxFieldIdentifier;
+        }
+    };
+
+   private:
+    char* m_cursor { nullptr };
+    std::size_t m_size { 0 };
+};
+
+// Serializes messages into the OD4 wire format
+//    0x0D 0xA4 LEN0 LEN1 LEN2 Proto-encoded cluon::data::Envelope
+// reusing its buffer, so steady-state encoding does not allocate.
+class EnvelopeEncoder {
+   public:
+    static constexpr std::size_t OD4_HEADER_SIZE { 5 };
+
+    explicit EnvelopeEncoder(std::size_t initialCapacity = 512);
+
+    // Encodes the message and returns the reused buffer holding header and envelope.
+    template <typename T>
+    std::string& encode(T& message, const cluon::data::TimeStamp& sent, const cluon::data::TimeStamp& sampleTimeStamp, uint32_t senderStamp = 0) noexcept {
+        int32_t dataType { static_cast<int32_t>(T::ID()) };
+        cluon::data::TimeStamp received;
+        cluon::data::TimeStamp sentTimeStamp { sent };
+        cluon::data::TimeStamp sampleTime { (0 == (sampleTimeStamp.seconds() + sampleTimeStamp.microseconds())) ? sent : sampleTimeStamp };
+
+        // First pass: count bytes.
+        ProtoEncoder counter;
+        encodeEnvelope(counter, dataType, message, sentTimeStamp, received, sampleTime, senderStamp);
+        const std::size_t LENGTH { counter.size() };
+
+        // Second pass: write into the presized buffer.
+        if (m_buffer.size() != OD4_HEADER_SIZE + LENGTH) {
+            m_buffer.resize(OD4_HEADER_SIZE + LENGTH);
+        }
+        writeHeader(LENGTH);
+        ProtoEncoder writer { &m_buffer[OD4_HEADER_SIZE] };
+        encodeEnvelope(writer, dataType, message, sentTimeStamp, received, sampleTime, senderStamp);
+        return m_buffer;
+    }
+
+    const std::string& buffer() const noexcept;
+
+   private:
+    template <typename T>
+    static void encodeEnvelope(ProtoEncoder& encoder, int32_t& dataType, T& message, cluon::data::TimeStamp& sent, cluon::data::TimeStamp& received, cluon::data::TimeStamp& sampleTimeStamp, uint32_t& senderStamp) noexcept {
+        // Field identifiers as in cluon::data::Envelope; the payload is nested in place of serializedData.
+        encoder.visit(1, std::string(), std::string(), dataType);
+        encoder.encodeNested(2, message);
+        encoder.encodeNested(3, sent);
+        encoder.encodeNested(4, received);
+        encoder.encodeNested(5, sampleTimeStamp);
+        encoder.visit(6, std::string(), std::string(), senderStamp);
+    }
+
+    void writeHeader(std::size_t length) noexcept;
+
+   private:
+    std::string m_buffer;
+};
+
+#endif
@@ -0,0 +1,153 @@
+// Bounded lock-free multi-producer/single-consumer pipeline; a drop-in for
+// cluon::NotifyingPipeline with the same add/notifyAll API. Producers enqueue
+// without locking and entries are moved, never copied; the consumer thread
+// drains everything available per wake-up before handing entries to the delegate.
+#ifndef MPSC_PIPELINE_H
+#define MPSC_PIPELINE_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+template <class T>
+class MpscPipeline {
+   private:
+    MpscPipeline(const MpscPipeline&) = delete;
+    MpscPipeline(MpscPipeline&&) = delete;
+    MpscPipeline& operator=(const MpscPipeline&) = delete;
+    MpscPipeline& operator=(MpscPipeline&&) = delete;
+
+   public:
+    // capacity is rounded up to the next power of two.
+    explicit MpscPipeline(std::function<void(T&&)> delegate, std::size_t capacity = 1024)
+        : m_delegate(std::move(delegate))
+        , m_mask(roundUpToPowerOfTwo(capacity) - 1)
+        , m_cells(new Cell[m_mask + 1]) {
+        for (std::size_t i { 0 }; i <= m_mask; i++) {
+            m_cells[i].m_sequence.store(i, std::memory_order_relaxed);
+        }
+        m_pipelineThreadRunning.store(true);
+        m_pipelineThread = std::thread(&MpscPipeline::processPipeline, this);
+    }
+
+    ~MpscPipeline() {
+        {
+            std::lock_guard<std::mutex> lck(m_sleepMutex);
+            m_pipelineThreadRunning.store(false);
+        }
+        m_pipelineCondition.notify_all();
+        try {
+            if (m_pipelineThread.joinable()) {
+                m_pipelineThread.join();
+            }
+        } catch (...) {
+        }
+    }
+
+   public:
+    // Returns false and drops the entry when the pipeline is full.
+    inline bool add(T&& entry) noexcept {
+        std::size_t pos { m_enqueuePosition.load(std::memory_order_relaxed) };
+        Cell* cell { nullptr };
+        for (;;) {
+            cell = &m_cells[pos & m_mask];
+            const std::size_t SEQUENCE { cell->m_sequence.load(std::memory_order_acquire) };
+            const intptr_t DIFF { static_cast<intptr_t>(SEQUENCE) - static_cast<intptr_t>(pos) };
+            if (0 == DIFF) {
+                if (m_enqueuePosition.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (0 > DIFF) {
+                m_dropped.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            } else {
+                pos = m_enqueuePosition.load(std::memory_order_relaxed);
+            }
+        }
+        cell->m_entry = std::move(entry);
+        cell->m_sequence.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Wakes the consumer; only takes a lock when the consumer is actually asleep.
+    inline void notifyAll() noexcept {
+        // Orders the preceding add() before reading the consumer's state.
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (m_consumerSleeping.load()) {
+            std::lock_guard<std::mutex> lck(m_sleepMutex);
+            m_pipelineCondition.notify_all();
+        }
+    }
+
+    inline bool isRunning() noexcept { return m_pipelineThreadRunning.load(); }
+
+    inline uint64_t numberOfDropped() const noexcept { return m_dropped.load(std::memory_order_relaxed); }
+
+   private:
+    struct Cell {
+        std::atomic<std::size_t> m_sequence { 0 };
+        T m_entry {};
+    };
+
+    static std::size_t roundUpToPowerOfTwo(std::size_t v) noexcept {
+        std::size_t p { 2 };
+        while (p < v) {
+            p <<= 1;
+        }
+        return p;
+    }
+
+    inline bool empty() const noexcept {
+        const Cell& cell = m_cells[m_dequeuePosition & m_mask];
+        return cell.m_sequence.load(std::memory_order_acquire) != m_dequeuePosition + 1;
+    }
+
+    // Drains all entries available right now; only called from the consumer thread.
+    inline void drain() noexcept {
+        while (!empty()) {
+            Cell& cell = m_cells[m_dequeuePosition & m_mask];
+            T entry { std::move(cell.m_entry) };
+            cell.m_sequence.store(m_dequeuePosition + m_mask + 1, std::memory_order_release);
+            m_dequeuePosition++;
+
+            if (nullptr != m_delegate) {
+                m_delegate(std::move(entry));
+            }
+        }
+    }
+
+    inline void processPipeline() noexcept {
+        while (m_pipelineThreadRunning.load()) {
+            drain();
+
+            std::unique_lock<std::mutex> lck(m_sleepMutex);
+            m_consumerSleeping.store(true);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            // Re-check after announcing sleep so that no notifyAll can be missed.
+            m_pipelineCondition.wait(lck, [this] { return (!this->m_pipelineThreadRunning.load() || !this->empty()); });
+            m_consumerSleeping.store(false);
+        }
+    }
+
+   private:
+    std::function<void(T&&)> m_delegate;
+    const std::size_t m_mask;
+    std::unique_ptr<Cell[]> m_cells;
+
+    std::atomic<std::size_t> m_enqueuePosition { 0 };
+    std::size_t m_dequeuePosition { 0 };
+    std::atomic<uint64_t> m_dropped { 0 };
+
+    std::atomic<bool> m_pipelineThreadRunning { false };
+    std::atomic<bool> m_consumerSleeping { false };
+    std::thread m_pipelineThread {};
+    std::mutex m_sleepMutex {};
+    std::condition_variable m_pipelineCondition {};
+};
+
+#endif
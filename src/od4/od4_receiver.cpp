@@ -0,0 +1,167 @@
+#include "od4_receiver.hpp"
+#include <algorithm>
+#include <sstream>
+
+Od4Receiver::Od4Receiver(uint16_t cid, uint16_t localSendFromPort)
+    : m_dispatchTable { nullptr }
+    , m_readerEpoch { 0 }
+    , m_writerMutex {}
+    , m_currentTable { new DispatchTable() }
+    , m_retiredTables {}
+    , m_receiver { nullptr } {
+    m_dispatchTable.store(m_currentTable.get());
+
+    m_receiver = std::make_unique<cluon::UDPReceiver>(
+        "225.0.0." + std::to_string(cid),
+        12175,
+        [this](std::string&& data, std::string&& from, std::chrono::system_clock::time_point&& timepoint) {
+            this->callback(std::move(data), std::move(from), std::move(timepoint));
+        },
+        localSendFromPort);
+}
+
+Od4Receiver::~Od4Receiver() {
+    // Stop receiving before the tables and workers go away.
+    m_receiver.reset();
+}
+
+bool Od4Receiver::dataTrigger(int32_t messageIdentifier, Delegate delegate, Dispatch dispatch) noexcept {
+    bool retVal { false };
+    try {
+        std::lock_guard<std::mutex> lck(m_writerMutex);
+        std::unique_ptr<DispatchTable> table { new DispatchTable(*m_dispatchTable.load()) };
+        auto it = std::lower_bound(table->begin(), table->end(), messageIdentifier, [](const Entry& e, int32_t id) { return e.m_dataType < id; });
+        if ((it != table->end()) && (it->m_dataType == messageIdentifier)) {
+            it = table->erase(it);
+        }
+        if (nullptr != delegate) {
+            std::shared_ptr<MpscPipeline<cluon::data::Envelope>> worker;
+            if (Dispatch::QUEUED == dispatch) {
+                worker = std::make_shared<MpscPipeline<cluon::data::Envelope>>(delegate);
+            }
+            table->insert(it, Entry { messageIdentifier, std::move(delegate), std::move(worker) });
+        }
+        m_dispatchTable.store(table.get());
+        // Tagged with the epoch after publishing: only a callback already running
+        // now can still hold the previous table.
+        m_retiredTables.push_back(RetiredTable { m_readerEpoch.load(), std::move(m_currentTable) });
+        m_currentTable = std::move(table);
+        reclaim();
+        retVal = true;
+    } catch (...) {
+    }
+    return retVal;
+}
+
+void Od4Receiver::reclaim() noexcept {
+    // An even epoch means the receiver thread is outside callback() and will load
+    // the current table next; otherwise, tables retired during the running
+    // callback are kept until it returns.
+    const uint64_t EPOCH { m_readerEpoch.load() };
+    m_retiredTables.erase(std::remove_if(m_retiredTables.begin(), m_retiredTables.end(),
+                              [EPOCH](const RetiredTable& retired) { return (0 == (EPOCH % 2)) || (retired.m_epoch != EPOCH); }),
+        m_retiredTables.end());
+}
+
+bool Od4Receiver::isRunning() noexcept {
+    return m_receiver->isRunning();
+}
+
+const Od4Receiver::Entry* Od4Receiver::find(const DispatchTable& table, int32_t dataType) noexcept {
+    auto it = std::lower_bound(table.begin(), table.end(), dataType, [](const Entry& e, int32_t id) { return e.m_dataType < id; });
+    return ((it != table.end()) && (it->m_dataType == dataType)) ? &(*it) : nullptr;
+}
+
+bool Od4Receiver::peekDataType(const std::string& data, int32_t& dataType) noexcept {
+    constexpr std::size_t OD4_HEADER_SIZE { 5 };
+    if ((data.size() <= OD4_HEADER_SIZE) || (0x0D != static_cast<uint8_t>(data[0])) || (0xA4 != static_cast<uint8_t>(data[1]))) {
+        return false;
+    }
+
+    const uint8_t* pos { reinterpret_cast<const uint8_t*>(data.data()) + OD4_HEADER_SIZE };
+    const uint8_t* end { reinterpret_cast<const uint8_t*>(data.data()) + data.size() };
+    auto readVarInt = [&pos, end](uint64_t& value) {
+        value = 0;
+        for (uint8_t shift { 0 }; (pos < end) && (shift < 64); shift = static_cast<uint8_t>(shift + 7)) {
+            const uint8_t b { *pos++ };
+            value |= static_cast<uint64_t>(b & 0x7f) << shift;
+            if (0 == (b & 0x80)) {
+                return true;
+            }
+        }
+        return false;
+    };
+
+    // dataType is field 1 and encoded first; other fields are skipped by wire type to be safe.
+    while (pos < end) {
+        uint64_t key { 0 };
+        uint64_t value { 0 };
+        if (!readVarInt(key)) {
+            return false;
+        }
+        const uint8_t WIRE_TYPE { static_cast<uint8_t>(key & 0x7) };
+        if (static_cast<uint8_t>(cluon::ProtoConstants::VARINT) == WIRE_TYPE) {
+            if (!readVarInt(value)) {
+                return false;
+            }
+            if (1 == (key >> 3)) {
+                const uint32_t ZIGZAG { static_cast<uint32_t>(value) };
+                dataType = static_cast<int32_t>((ZIGZAG >> 1) ^ -(ZIGZAG & 1));
+                return true;
+            }
+        } else if (static_cast<uint8_t>(cluon::ProtoConstants::LENGTH_DELIMITED) == WIRE_TYPE) {
+            if (!readVarInt(value) || (value > static_cast<uint64_t>(end - pos))) {
+                return false;
+            }
+            pos += value;
+        } else if (static_cast<uint8_t>(cluon::ProtoConstants::FOUR_BYTES) == WIRE_TYPE) {
+            pos += 4;
+        } else if (static_cast<uint8_t>(cluon::ProtoConstants::EIGHT_BYTES) == WIRE_TYPE) {
+            pos += 8;
+        } else {
+            return false;
+        }
+    }
+    return false;
+}
+
+void Od4Receiver::callback(std::string&& data, std::string&& /*from*/, std::chrono::system_clock::time_point&& timepoint) noexcept {
+    // Entering makes the epoch odd before the table is loaded; leaving makes it
+    // even again after the last use of the table.
+    struct Quiescence {
+        std::atomic<uint64_t>& m_epoch;
+        ~Quiescence() { m_epoch.fetch_add(1, std::memory_order_release); }
+    };
+    m_readerEpoch.fetch_add(1);
+    Quiescence quiescence { m_readerEpoch };
+
+    const DispatchTable* table { m_dispatchTable.load() };
+    if (table->empty()) {
+        return;
+    }
+
+    // Drop unsubscribed messages before any decoding or allocation.
+    int32_t dataType { 0 };
+    const Entry* entry { peekDataType(data, dataType) ? find(*table, dataType) : nullptr };
+    if (nullptr == entry) {
+        return;
+    }
+
+    std::stringstream sstr(data);
+    auto retVal = cluon::extractEnvelope(sstr);
+    if (retVal.first) {
+        if (entry->m_dataType == retVal.second.dataType()) {
+            cluon::data::Envelope env { std::move(retVal.second) };
+            env.received(cluon::time::convert(timepoint));
+            try {
+                if (entry->m_worker) {
+                    entry->m_worker->add(std::move(env));
+                    entry->m_worker->notifyAll();
+                } else {
+                    entry->m_delegate(std::move(env));
+                }
+            } catch (...) {
+            }
+        }
+    }
+}
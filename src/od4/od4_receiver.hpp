@@ -0,0 +1,77 @@
+// Receiving side of an OD4 session with a wait-free dataTrigger dispatch table.
+#ifndef OD4_RECEIVER_H
+#define OD4_RECEIVER_H
+
+#include "cluon-complete.hpp"
+#include <od4/mpsc_pipeline.hpp>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+class Od4Receiver {
+   private:
+    Od4Receiver(const Od4Receiver&) = delete;
+    Od4Receiver(Od4Receiver&&) = delete;
+    Od4Receiver& operator=(const Od4Receiver&) = delete;
+    Od4Receiver& operator=(Od4Receiver&&) = delete;
+
+   public:
+    using Delegate = std::function<void(cluon::data::Envelope&& envelope)>;
+
+    // How a delegate is invoked: on the receiver thread or on its own worker queue.
+    enum class Dispatch { INLINE,
+        QUEUED };
+
+    // localSendFromPort: envelopes sent from this local port are ignored.
+    explicit Od4Receiver(uint16_t cid, uint16_t localSendFromPort = 0);
+    ~Od4Receiver();
+
+    // Sets (or erases with nullptr) the delegate for a message identifier. QUEUED
+    // delegates run on a per-message-type worker so a slow one cannot stall others.
+    bool dataTrigger(int32_t messageIdentifier, Delegate delegate, Dispatch dispatch = Dispatch::INLINE) noexcept;
+
+    bool isRunning() noexcept;
+
+   private:
+    struct Entry {
+        int32_t m_dataType;
+        Delegate m_delegate;
+        std::shared_ptr<MpscPipeline<cluon::data::Envelope>> m_worker;
+    };
+    // Immutable once published; sorted by data type.
+    using DispatchTable = std::vector<Entry>;
+
+    void callback(std::string&& data, std::string&& from, std::chrono::system_clock::time_point&& timepoint) noexcept;
+    static const Entry* find(const DispatchTable& table, int32_t dataType) noexcept;
+    // Reads the Envelope's dataType straight from the OD4 frame without decoding it.
+    static bool peekDataType(const std::string& data, int32_t& dataType) noexcept;
+
+    // A replaced table and the reader epoch it might still be read in.
+    struct RetiredTable {
+        uint64_t m_epoch;
+        std::unique_ptr<const DispatchTable> m_table;
+    };
+    // Frees the retired tables the receiver thread cannot be reading any more.
+    void reclaim() noexcept;
+
+   private:
+    // Readers load the current table without locking; writers copy, modify and
+    // publish under m_writerMutex. The receiver thread is the only reader and
+    // bumps m_readerEpoch on entering and leaving callback() (odd while inside),
+    // so a replaced table is freed as soon as the callback that might hold it
+    // has returned.
+    std::atomic<const DispatchTable*> m_dispatchTable;
+    std::atomic<uint64_t> m_readerEpoch;
+    std::mutex m_writerMutex;
+    std::unique_ptr<const DispatchTable> m_currentTable;
+    std::vector<RetiredTable> m_retiredTables;
+
+    std::unique_ptr<cluon::UDPReceiver> m_receiver;
+};
+
+#endif
@@ -0,0 +1,98 @@
+#include "prediction_publisher.hpp"
+#include <cstring>
+#include <iostream>
+#include <string>
+
+PredictionPublisher::PredictionPublisher(uint16_t cid, uint32_t senderStamp, float maxRate)
+    : m_sender { "225.0.0." + std::to_string(cid), 12175 }
+    , m_encoder {}
+    , m_senderStamp { senderStamp }
+    , m_minInterval { static_cast<int64_t>(1000000.0f / ((maxRate > 0) ? maxRate : 1.0f)) }
+    , m_mutex {}
+    , m_condition {}
+    , m_running { true }
+    , m_pending { false }
+    , m_latest {}
+    , m_latestSampleTimeStamp {}
+    , m_published { 0 }
+    , m_coalesced { 0 }
+    , m_failed { 0 }
+    , m_thread {} {
+    m_thread = std::thread(&PredictionPublisher::run, this);
+}
+
+PredictionPublisher::~PredictionPublisher() {
+    {
+        std::lock_guard<std::mutex> lck(m_mutex);
+        m_running = false;
+    }
+    m_condition.notify_all();
+    if (m_thread.joinable()) {
+        m_thread.join();
+    }
+}
+
+void PredictionPublisher::publish(float groundSteering, const cluon::data::TimeStamp& sampleTimeStamp) noexcept {
+    {
+        std::lock_guard<std::mutex> lck(m_mutex);
+        if (m_pending) {
+            m_coalesced++;
+        }
+        m_latest.groundSteering(groundSteering);
+        m_latestSampleTimeStamp = sampleTimeStamp;
+        m_pending = true;
+    }
+    m_condition.notify_one();
+}
+
+uint16_t PredictionPublisher::sendFromPort() const noexcept {
+    return m_sender.getSendFromPort();
+}
+
+uint64_t PredictionPublisher::numberOfPublished() const noexcept {
+    return m_published.load();
+}
+
+uint64_t PredictionPublisher::numberOfCoalesced() const noexcept {
+    return m_coalesced.load();
+}
+
+uint64_t PredictionPublisher::numberOfFailed() const noexcept {
+    return m_failed.load();
+}
+
+void PredictionPublisher::run() noexcept {
+    auto nextSend = std::chrono::steady_clock::now();
+    std::unique_lock<std::mutex> lck(m_mutex);
+    while (m_running) {
+        m_condition.wait(lck, [this]() { return m_pending || !m_running; });
+        // Respect the maximum rate; predictions arriving meanwhile replace the pending one.
+        m_condition.wait_until(lck, nextSend, [this]() { return !m_running; });
+        if (!m_running) {
+            break;
+        }
+
+        opendlv::proxy::GroundSteeringRequest gsr { m_latest };
+        const cluon::data::TimeStamp sampleTimeStamp { m_latestSampleTimeStamp };
+        m_pending = false;
+        lck.unlock();
+
+        // The encoder stamps the envelope like OD4Session::send: sent time now,
+        // the given sample time and our sender stamp.
+        std::string& data = m_encoder.encode(gsr, cluon::time::now(), sampleTimeStamp, m_senderStamp);
+        const std::size_t SIZE { data.size() };
+        // UDPSender::send only reads from the string, so the encoder keeps its buffer.
+        const auto SENT = m_sender.send(std::move(data));
+        if ((SENT.first < 0) || (static_cast<std::size_t>(SENT.first) != SIZE)) {
+            // Log the first failure and then every 100th, so a lost network does not flood the log.
+            if (0 == (m_failed++ % 100)) {
+                std::cerr << "[PredictionPublisher]: Failed to send prediction (" << m_failed.load() << " failed so far): " << ((0 != SENT.second) ? std::strerror(SENT.second) : "short write") << std::endl;
+            }
+        } else {
+            m_published++;
+        }
+        nextSend = std::chrono::steady_clock::now() + m_minInterval;
+
+        lck.lock();
+    }
+}
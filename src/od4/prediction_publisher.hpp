@@ -0,0 +1,61 @@
+// Publishes steering predictions as opendlv.proxy.GroundSteeringRequest from a
+// dedicated sender thread, so network I/O never blocks the frame loop.
+#ifndef PREDICTION_PUBLISHER_H
+#define PREDICTION_PUBLISHER_H
+
+#include "cluon-complete.hpp"
+#include "opendlv-standard-message-set.hpp"
+#include <od4/envelope_encoder.hpp>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+
+class PredictionPublisher {
+   private:
+    PredictionPublisher(const PredictionPublisher&) = delete;
+    PredictionPublisher(PredictionPublisher&&) = delete;
+    PredictionPublisher& operator=(const PredictionPublisher&) = delete;
+    PredictionPublisher& operator=(PredictionPublisher&&) = delete;
+
+   public:
+    // maxRate in Hz; predictions arriving faster are coalesced to the latest one.
+    PredictionPublisher(uint16_t cid, uint32_t senderStamp, float maxRate);
+    ~PredictionPublisher();
+
+    // Hands the prediction to the sender thread; never blocks on the network.
+    void publish(float groundSteering, const cluon::data::TimeStamp& sampleTimeStamp) noexcept;
+
+    // Local UDP port the predictions are sent from.
+    uint16_t sendFromPort() const noexcept;
+
+    uint64_t numberOfPublished() const noexcept;
+    uint64_t numberOfCoalesced() const noexcept;
+    // Predictions the socket did not accept; they are not retried.
+    uint64_t numberOfFailed() const noexcept;
+
+   private:
+    void run() noexcept;
+
+   private:
+    cluon::UDPSender m_sender;
+    EnvelopeEncoder m_encoder;
+    const uint32_t m_senderStamp;
+    const std::chrono::microseconds m_minInterval;
+
+    std::mutex m_mutex;
+    std::condition_variable m_condition;
+    bool m_running;
+    bool m_pending;
+    opendlv::proxy::GroundSteeringRequest m_latest;
+    cluon::data::TimeStamp m_latestSampleTimeStamp;
+
+    std::atomic<uint64_t> m_published;
+    std::atomic<uint64_t> m_coalesced;
+    std::atomic<uint64_t> m_failed;
+    std::thread m_thread;
+};
+
+#endif
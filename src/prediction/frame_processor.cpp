@@ -0,0 +1,31 @@
+#include "frame_processor.hpp"
+#include <prediction/predict.hpp>
+
+FrameProcessor::FrameProcessor(std::size_t numberOfCameras, const ConeDetectorOptions& options)
+    : m_mutex()
+    , m_angularVelocityZ(0.0f)
+    , m_detectors()
+    , m_result() {
+    for (std::size_t i { 0 }; i < numberOfCameras; i++) {
+        m_detectors.emplace_back(new ConeDetector { options });
+    }
+    m_result.m_cones.resize(numberOfCameras);
+}
+
+void FrameProcessor::setAngularVelocityZ(float angularVelocityZ) {
+    std::lock_guard<std::mutex> lck(m_mutex);
+    m_angularVelocityZ = angularVelocityZ;
+}
+
+float FrameProcessor::angularVelocityZ() const {
+    std::lock_guard<std::mutex> lck(m_mutex);
+    return m_angularVelocityZ;
+}
+
+const FrameResult& FrameProcessor::process(const std::vector<FrameView>& frames) {
+    m_result.m_prediction = predict(angularVelocityZ());
+    for (std::size_t i { 0 }; i < m_detectors.size(); i++) {
+        m_result.m_cones[i] = (i < frames.size()) ? m_detectors[i]->process(frames[i]) : ConeResult();
+    }
+    return m_result;
+}
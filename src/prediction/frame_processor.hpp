@@ -0,0 +1,45 @@
+// The work done for every frame, shared by live processing, `main --replay`
+// and replay-diff so that their results cannot drift apart: the steering
+// prediction from the latest AngularVelocityReading and the cones in each
+// camera's frame.
+#ifndef FRAME_PROCESSOR_H
+#define FRAME_PROCESSOR_H
+
+#include <cone_detection/cone_detector.hpp>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+struct FrameResult {
+    double m_prediction { 0.0 };
+    // Nearest cones per camera.
+    std::vector<ConeResult> m_cones {};
+};
+
+class FrameProcessor {
+   private:
+    FrameProcessor(const FrameProcessor&) = delete;
+    FrameProcessor(FrameProcessor&&) = delete;
+    FrameProcessor& operator=(const FrameProcessor&) = delete;
+    FrameProcessor& operator=(FrameProcessor&&) = delete;
+
+   public:
+    explicit FrameProcessor(std::size_t numberOfCameras, const ConeDetectorOptions& options = ConeDetectorOptions());
+
+    // May be called from any thread.
+    void setAngularVelocityZ(float angularVelocityZ);
+    float angularVelocityZ() const;
+
+    // Processes one frame per camera, in camera order; cameras without a frame
+    // or with an empty one have no cones. The result is valid until the next call.
+    const FrameResult& process(const std::vector<FrameView>& frames);
+
+   private:
+    mutable std::mutex m_mutex;
+    float m_angularVelocityZ;
+    std::vector<std::unique_ptr<ConeDetector>> m_detectors;
+    FrameResult m_result;
+};
+
+#endif
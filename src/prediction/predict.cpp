@@ -0,0 +1,14 @@
+#include "predict.hpp"
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+double predict(double speed) {
+    std::vector<double> coefficients = {0.00000000e+00, 3.96583242e-03, -1.05373477e-04, -3.17407267e-07, 4.68268257e-08, -1.49984238e-10, -5.54462195e-12, 3.47391935e-14};
+    double intercept = 0.05159669059756054;
+    double prediction = intercept;
+    for (std::size_t i = 0; i < coefficients.size(); i++) {
+        prediction += coefficients[i] * std::pow(speed, i);
+    }
+    return prediction;
+}
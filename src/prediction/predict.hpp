@@ -0,0 +1,8 @@
+// Polynomial model of the ground steering angle over the angular velocity around z.
+#ifndef PREDICT_H
+#define PREDICT_H
+
+//function that returns the predicted ground steering angle
+double predict(double speed);
+
+#endif
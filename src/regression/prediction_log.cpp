@@ -0,0 +1,140 @@
+#include "prediction_log.hpp"
+#include "opendlv-standard-message-set.hpp"
+#include <prediction/frame_processor.hpp>
+#include <replay/frame_replay.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+
+namespace {
+constexpr char LOG_MAGIC[8] { 'P', 'R', 'E', 'D', 'L', 'O', 'G', '2' };
+constexpr uint32_t LOG_BYTE_ORDER { 0x01020304 };
+
+// Log layout: header followed by the time stamp, the prediction and the cone
+// coordinate columns (left x, left y, right x, right y as int32).
+struct LogHeader {
+    char m_magic[8];
+    uint32_t m_byteOrder;
+    uint32_t m_reserved;
+    uint64_t m_numberOfRecords;
+};
+}
+
+bool replayPredictions(const std::string& recFile, std::vector<PredictionRecord>& records, RecordingPlayer::Source source) {
+    records.clear();
+    FrameReplay replay { recFile, { EnvelopeFilter { opendlv::proxy::AngularVelocityReading::ID() } }, source };
+    if (!replay.valid()) {
+        return false;
+    }
+    records.reserve(replay.numberOfFrames());
+    FrameProcessor processor { 1 };
+    std::vector<FrameView> frames(1);
+    return replay.run(
+        [&records, &processor, &frames](const cluon::data::TimeStamp& sampleTimeStamp, const cv::Mat& image) {
+            frames[0] = FrameView { PixelFormat::BGR, image };
+            const FrameResult& result { processor.process(frames) };
+            records.push_back(PredictionRecord { cluon::time::toMicroseconds(sampleTimeStamp), result.m_prediction, result.m_cones[0] });
+            return true;
+        },
+        [&processor](cluon::data::Envelope&& env) { processor.setAngularVelocityZ(cluon::extractMessage<opendlv::proxy::AngularVelocityReading>(std::move(env)).angularVelocityZ()); });
+}
+
+bool writePredictionLog(const std::string& file, const std::vector<PredictionRecord>& records) {
+    const std::string TMP { file + ".tmp" };
+    {
+        std::ofstream out(TMP, std::ios::binary | std::ios::trunc);
+        if (!out.good()) {
+            return false;
+        }
+        LogHeader header {};
+        std::copy(std::begin(LOG_MAGIC), std::end(LOG_MAGIC), header.m_magic);
+        header.m_byteOrder = LOG_BYTE_ORDER;
+        header.m_numberOfRecords = records.size();
+        out.write(reinterpret_cast<const char*>(&header), sizeof(LogHeader));
+        for (const auto& r : records) {
+            out.write(reinterpret_cast<const char*>(&r.m_sampleTimeStamp), sizeof(r.m_sampleTimeStamp));
+        }
+        for (const auto& r : records) {
+            out.write(reinterpret_cast<const char*>(&r.m_prediction), sizeof(r.m_prediction));
+        }
+        for (auto coordinate : { &ConeResult::m_left, &ConeResult::m_right }) {
+            for (auto axis : { &cv::Point::x, &cv::Point::y }) {
+                for (const auto& r : records) {
+                    const int32_t VALUE { static_cast<int32_t>((r.m_cones.*coordinate).*axis) };
+                    out.write(reinterpret_cast<const char*>(&VALUE), sizeof(VALUE));
+                }
+            }
+        }
+        if (!out.good()) {
+            return false;
+        }
+    }
+    return 0 == std::rename(TMP.c_str(), file.c_str());
+}
+
+bool readPredictionLog(const std::string& file, std::vector<PredictionRecord>& records) {
+    records.clear();
+    std::ifstream in(file, std::ios::binary);
+    LogHeader header {};
+    in.read(reinterpret_cast<char*>(&header), sizeof(LogHeader));
+    if (!in.good() || !std::equal(std::begin(LOG_MAGIC), std::end(LOG_MAGIC), header.m_magic) || (LOG_BYTE_ORDER != header.m_byteOrder)) {
+        return false;
+    }
+    std::vector<int64_t> timeStamps(static_cast<std::size_t>(header.m_numberOfRecords));
+    std::vector<double> predictions(timeStamps.size());
+    std::vector<int32_t> cones(4 * timeStamps.size());
+    in.read(reinterpret_cast<char*>(timeStamps.data()), static_cast<std::streamsize>(timeStamps.size() * sizeof(int64_t)));
+    in.read(reinterpret_cast<char*>(predictions.data()), static_cast<std::streamsize>(predictions.size() * sizeof(double)));
+    in.read(reinterpret_cast<char*>(cones.data()), static_cast<std::streamsize>(cones.size() * sizeof(int32_t)));
+    if (!in.good()) {
+        return false;
+    }
+    const std::size_t N { timeStamps.size() };
+    records.reserve(N);
+    for (std::size_t i { 0 }; i < N; i++) {
+        const ConeResult CONES { cv::Point(cones[i], cones[N + i]), cv::Point(cones[2 * N + i], cones[3 * N + i]) };
+        records.push_back(PredictionRecord { timeStamps[i], predictions[i], CONES });
+    }
+    return true;
+}
+
+PredictionDiff diffPredictions(const std::vector<PredictionRecord>& golden, const std::vector<PredictionRecord>& actual, double tolerance) {
+    PredictionDiff diff;
+    diff.m_numberOfFrames = actual.size();
+    const std::size_t N { (std::min)(golden.size(), actual.size()) };
+    for (std::size_t i { 0 }; i < N; i++) {
+        const double DIFFERENCE { std::fabs(golden[i].m_prediction - actual[i].m_prediction) };
+        diff.m_maxDifference = (std::max)(diff.m_maxDifference, DIFFERENCE);
+        const bool SAME_CONES { (golden[i].m_cones.m_left == actual[i].m_cones.m_left) && (golden[i].m_cones.m_right == actual[i].m_cones.m_right) };
+        // NaN never compares within tolerance.
+        if ((golden[i].m_sampleTimeStamp != actual[i].m_sampleTimeStamp) || !(DIFFERENCE <= tolerance) || !SAME_CONES) {
+            if (diff.m_equal) {
+                std::stringstream sstr;
+                sstr << "frame " << i << " at " << actual[i].m_sampleTimeStamp << ": golden " << golden[i].m_prediction << " @ " << golden[i].m_sampleTimeStamp << ", got " << actual[i].m_prediction;
+                if (!SAME_CONES) {
+                    const ConeResult& g { golden[i].m_cones };
+                    const ConeResult& a { actual[i].m_cones };
+                    sstr << "; golden cones (" << g.m_left.x << ", " << g.m_left.y << ")/(" << g.m_right.x << ", " << g.m_right.y << "), got (" << a.m_left.x << ", " << a.m_left.y << ")/(" << a.m_right.x << ", " << a.m_right.y << ")";
+                }
+                diff.m_reason = sstr.str();
+                diff.m_firstMismatch = i;
+            }
+            diff.m_equal = false;
+            diff.m_numberOfMismatches++;
+            diff.m_numberOfConeMismatches += SAME_CONES ? 0 : 1;
+        }
+    }
+    if (golden.size() != actual.size()) {
+        if (diff.m_equal) {
+            std::stringstream sstr;
+            sstr << golden.size() << " golden frames, got " << actual.size();
+            diff.m_reason = sstr.str();
+            diff.m_firstMismatch = N;
+        }
+        diff.m_equal = false;
+        diff.m_numberOfMismatches += (std::max)(golden.size(), actual.size()) - N;
+    }
+    return diff;
+}
@@ -0,0 +1,45 @@
+// Per-frame predictions and detected cones of a replayed recording, stored as a
+// compact binary log so that changes to the detector or predictor can be
+// checked against a golden run.
+#ifndef PREDICTION_LOG_H
+#define PREDICTION_LOG_H
+
+#include <cone_detection/cone_detector.hpp>
+#include <replay/recording_player.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+struct PredictionRecord {
+    // Sample time stamp of the frame in microseconds.
+    int64_t m_sampleTimeStamp;
+    double m_prediction;
+    ConeResult m_cones;
+};
+
+struct PredictionDiff {
+    bool m_equal { true };
+    std::size_t m_numberOfFrames { 0 };
+    std::size_t m_numberOfMismatches { 0 };
+    // Frames whose cones differ; they count as mismatches as well.
+    std::size_t m_numberOfConeMismatches { 0 };
+    // Index of the first frame differing in time stamp, cones or beyond the tolerance.
+    std::size_t m_firstMismatch { 0 };
+    double m_maxDifference { 0.0 };
+    std::string m_reason {};
+};
+
+// Replays the recording headlessly like `main --replay --speed=max`, through
+// the same FrameReplay and FrameProcessor: every ImageReading is a frame,
+// predicted from the latest AngularVelocityReading, with the cones in its image.
+bool replayPredictions(const std::string& recFile, std::vector<PredictionRecord>& records, RecordingPlayer::Source source = RecordingPlayer::Source::MAPPED);
+
+bool writePredictionLog(const std::string& file, const std::vector<PredictionRecord>& records);
+bool readPredictionLog(const std::string& file, std::vector<PredictionRecord>& records);
+
+// Frames must match in number, time stamps and cones; predictions may differ by
+// at most tolerance.
+PredictionDiff diffPredictions(const std::vector<PredictionRecord>& golden, const std::vector<PredictionRecord>& actual, double tolerance);
+
+#endif
@@ -0,0 +1,161 @@
+// Replays all recordings headlessly in parallel and diffs their per-frame
+// predictions and cones against golden logs.
+#include "cluon-complete.hpp"
+#include <regression/prediction_log.hpp>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <dirent.h>
+#include <iostream>
+#include <string>
+#include <sys/stat.h>
+#include <thread>
+#include <vector>
+
+namespace {
+void findRecordings(const std::string& directory, std::vector<std::string>& recordings) {
+    DIR* dir { ::opendir(directory.c_str()) };
+    if (nullptr == dir) {
+        return;
+    }
+    while (struct dirent* entry = ::readdir(dir)) {
+        const std::string NAME { entry->d_name };
+        if (("." == NAME) || (".." == NAME)) {
+            continue;
+        }
+        const std::string PATH { directory + "/" + NAME };
+        struct stat st;
+        if (0 != ::stat(PATH.c_str(), &st)) {
+            continue;
+        }
+        if (S_ISDIR(st.st_mode)) {
+            findRecordings(PATH, recordings);
+        } else if ((NAME.size() > 4) && (0 == NAME.compare(NAME.size() - 4, 4, ".rec"))) {
+            recordings.push_back(PATH);
+        }
+    }
+    ::closedir(dir);
+}
+
+std::string baseName(const std::string& path) {
+    const std::size_t SLASH { path.find_last_of('/') };
+    return (std::string::npos == SLASH) ? path : path.substr(SLASH + 1);
+}
+
+struct Result {
+    bool m_replayed { false };
+    bool m_hasGolden { false };
+    PredictionDiff m_diff {};
+    int64_t m_durationInMicroseconds { 0 };
+};
+}
+
+int32_t main(int32_t argc, char** argv) {
+    int32_t retCode { 1 };
+    auto commandlineArguments = cluon::getCommandlineArguments(argc, argv);
+    if (0 != commandlineArguments.count("help")) {
+        std::cerr << argv[0] << " replays recordings headlessly and compares their predictions and cones to golden logs." << std::endl;
+        std::cerr << "Usage:   " << argv[0] << " [--recordings=<directory>] [--golden=<directory>] [--output=<directory>] [--tolerance=<absolute>] [--threads=<n>] [--replay-source=mmap|read-ahead] [--update]" << std::endl;
+        std::cerr << "         --recordings: directory searched recursively for *.rec (default: recordings)" << std::endl;
+        std::cerr << "         --golden:     directory with the golden <recording>.pred logs (default: data/golden)" << std::endl;
+        std::cerr << "         --output:     directory to write the new <recording>.pred logs to (default: none)" << std::endl;
+        std::cerr << "         --tolerance:  maximum absolute difference per prediction; cones must match exactly (default: 1e-9)" << std::endl;
+        std::cerr << "         --threads:    number of recordings replayed in parallel (default: number of cores)" << std::endl;
+        std::cerr << "         --replay-source: read recordings through mmap or with io_uring read-ahead (default: mmap)" << std::endl;
+        std::cerr << "         --update:     replace the golden logs with the new predictions and cones" << std::endl;
+        std::cerr << "Example: " << argv[0] << " --recordings=recordings --golden=data/golden" << std::endl;
+        return retCode;
+    }
+
+    const std::string RECORDINGS { (0 != commandlineArguments.count("recordings")) ? commandlineArguments["recordings"] : "recordings" };
+    const std::string GOLDEN { (0 != commandlineArguments.count("golden")) ? commandlineArguments["golden"] : "data/golden" };
+    const std::string OUTPUT { (0 != commandlineArguments.count("output")) ? commandlineArguments["output"] : "" };
+    const double TOLERANCE { (0 != commandlineArguments.count("tolerance")) ? std::stod(commandlineArguments["tolerance"]) : 1e-9 };
+    const bool UPDATE { 0 != commandlineArguments.count("update") };
+    RecordingPlayer::Source source { RecordingPlayer::Source::MAPPED };
+    if ((0 != commandlineArguments.count("replay-source")) && !RecordingPlayer::parse(commandlineArguments["replay-source"], source)) {
+        std::cerr << argv[0] << ": Unknown --replay-source '" << commandlineArguments["replay-source"] << "'." << std::endl;
+        return retCode;
+    }
+
+    if (UPDATE) {
+        ::mkdir(GOLDEN.c_str(), 0755);
+    }
+    if (!OUTPUT.empty()) {
+        ::mkdir(OUTPUT.c_str(), 0755);
+    }
+
+    std::vector<std::string> recordings;
+    findRecordings(RECORDINGS, recordings);
+    std::sort(recordings.begin(), recordings.end());
+    if (recordings.empty()) {
+        std::cerr << argv[0] << ": No recordings found in '" << RECORDINGS << "'." << std::endl;
+        return retCode;
+    }
+
+    const uint32_t CORES { std::max(1u, std::thread::hardware_concurrency()) };
+    const uint32_t THREADS { std::min(static_cast<uint32_t>(recordings.size()), (0 != commandlineArguments.count("threads")) ? static_cast<uint32_t>(std::max(1, std::stoi(commandlineArguments["threads"]))) : CORES) };
+
+    // Each worker takes the next recording until all are done.
+    std::vector<Result> results(recordings.size());
+    std::atomic<std::size_t> next { 0 };
+    auto worker = [&]() {
+        for (std::size_t i { next++ }; i < recordings.size(); i = next++) {
+            const auto START { std::chrono::steady_clock::now() };
+            const std::string LOG { baseName(recordings[i]) + ".pred" };
+            std::vector<PredictionRecord> actual;
+            Result& result = results[i];
+            result.m_replayed = replayPredictions(recordings[i], actual, source);
+            if (result.m_replayed) {
+                if (!OUTPUT.empty() && !writePredictionLog(OUTPUT + "/" + LOG, actual)) {
+                    std::cerr << argv[0] << ": Could not write " << OUTPUT << "/" << LOG << std::endl;
+                }
+                std::vector<PredictionRecord> golden;
+                if (UPDATE) {
+                    result.m_hasGolden = writePredictionLog(GOLDEN + "/" + LOG, actual);
+                    result.m_diff.m_numberOfFrames = actual.size();
+                } else if ((result.m_hasGolden = readPredictionLog(GOLDEN + "/" + LOG, golden))) {
+                    result.m_diff = diffPredictions(golden, actual, TOLERANCE);
+                }
+            }
+            result.m_durationInMicroseconds = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - START).count();
+        }
+    };
+    const auto START { std::chrono::steady_clock::now() };
+    std::vector<std::thread> threads;
+    for (uint32_t t { 1 }; t < THREADS; t++) {
+        threads.emplace_back(worker);
+    }
+    worker();
+    for (auto& t : threads) {
+        t.join();
+    }
+    const auto DURATION { std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - START).count() };
+
+    uint32_t failed { 0 };
+    for (std::size_t i { 0 }; i < recordings.size(); i++) {
+        const Result& result = results[i];
+        std::cout << recordings[i] << ": ";
+        if (!result.m_replayed) {
+            std::cout << "FAILED (could not replay)";
+            failed++;
+        } else if (!result.m_hasGolden) {
+            std::cout << "FAILED (" << (UPDATE ? "could not write " : "no golden log ") << GOLDEN << "/" << baseName(recordings[i]) << ".pred)";
+            failed++;
+        } else if (UPDATE) {
+            std::cout << "UPDATED (" << result.m_diff.m_numberOfFrames << " frames)";
+        } else if (!result.m_diff.m_equal) {
+            std::cout << "FAILED (" << result.m_diff.m_numberOfMismatches << " of " << result.m_diff.m_numberOfFrames << " frames differ, " << result.m_diff.m_numberOfConeMismatches << " in cones; " << result.m_diff.m_reason << ")";
+            failed++;
+        } else {
+            std::cout << "OK (" << result.m_diff.m_numberOfFrames << " frames, max difference " << result.m_diff.m_maxDifference << ")";
+        }
+        std::cout << " in " << result.m_durationInMicroseconds / 1000 << "ms" << std::endl;
+    }
+    std::cout << (recordings.size() - failed) << "/" << recordings.size() << " recordings passed with " << THREADS << " thread(s) in " << DURATION << "ms." << std::endl;
+    if (0 == failed) {
+        retCode = 0;
+    }
+    return retCode;
+}
@@ -0,0 +1,148 @@
+#include "envelope_view.hpp"
+
+namespace {
+bool readVarInt(const uint8_t*& pos, const uint8_t* end, uint64_t& value) noexcept {
+    value = 0;
+    for (uint8_t shift { 0 }; (pos < end) && (shift < 64); shift = static_cast<uint8_t>(shift + 7)) {
+        const uint8_t b { *pos++ };
+        value |= static_cast<uint64_t>(b & 0x7f) << shift;
+        if (0 == (b & 0x80)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+int32_t fromZigZag32(uint64_t v) noexcept {
+    const uint32_t ZIGZAG { static_cast<uint32_t>(v) };
+    return static_cast<int32_t>((ZIGZAG >> 1) ^ -(ZIGZAG & 1));
+}
+
+// Skips a field of the given wire type; false if it does not fit.
+bool skipField(const uint8_t*& pos, const uint8_t* end, uint8_t wireType) noexcept {
+    uint64_t value { 0 };
+    switch (static_cast<cluon::ProtoConstants>(wireType)) {
+    case cluon::ProtoConstants::VARINT:
+        return readVarInt(pos, end, value);
+    case cluon::ProtoConstants::LENGTH_DELIMITED:
+        if (!readVarInt(pos, end, value) || (value > static_cast<uint64_t>(end - pos))) {
+            return false;
+        }
+        pos += value;
+        return true;
+    case cluon::ProtoConstants::FOUR_BYTES:
+        if (static_cast<std::size_t>(end - pos) < 4) {
+            return false;
+        }
+        pos += 4;
+        return true;
+    case cluon::ProtoConstants::EIGHT_BYTES:
+        if (static_cast<std::size_t>(end - pos) < 8) {
+            return false;
+        }
+        pos += 8;
+        return true;
+    }
+    return false;
+}
+
+bool parseTimeStamp(const uint8_t* pos, const uint8_t* end, cluon::data::TimeStamp& ts) noexcept {
+    while (pos < end) {
+        uint64_t key { 0 };
+        uint64_t value { 0 };
+        if (!readVarInt(pos, end, key)) {
+            return false;
+        }
+        const uint8_t WIRE_TYPE { static_cast<uint8_t>(key & 0x7) };
+        if ((static_cast<uint8_t>(cluon::ProtoConstants::VARINT) == WIRE_TYPE) && ((1 == (key >> 3)) || (2 == (key >> 3)))) {
+            if (!readVarInt(pos, end, value)) {
+                return false;
+            }
+            if (1 == (key >> 3)) {
+                ts.seconds(fromZigZag32(value));
+            } else {
+                ts.microseconds(fromZigZag32(value));
+            }
+        } else if (!skipField(pos, end, WIRE_TYPE)) {
+            return false;
+        }
+    }
+    return true;
+}
+}
+
+bool parseOD4Header(const char* data, std::size_t available, uint32_t& length) noexcept {
+    if ((available < OD4_HEADER_SIZE) || (0x0D != static_cast<uint8_t>(data[0])) || (0xA4 != static_cast<uint8_t>(data[1]))) {
+        return false;
+    }
+    length = static_cast<uint32_t>(static_cast<uint8_t>(data[2])) | (static_cast<uint32_t>(static_cast<uint8_t>(data[3])) << 8)
+        | (static_cast<uint32_t>(static_cast<uint8_t>(data[4])) << 16);
+    return true;
+}
+
+bool parseEnvelope(const char* data, std::size_t length, EnvelopeView& view) noexcept {
+    view = EnvelopeView {};
+    const uint8_t* pos { reinterpret_cast<const uint8_t*>(data) };
+    const uint8_t* end { pos + length };
+    while (pos < end) {
+        uint64_t key { 0 };
+        uint64_t value { 0 };
+        if (!readVarInt(pos, end, key)) {
+            return false;
+        }
+        const uint32_t FIELD { static_cast<uint32_t>(key >> 3) };
+        const uint8_t WIRE_TYPE { static_cast<uint8_t>(key & 0x7) };
+        if (static_cast<uint8_t>(cluon::ProtoConstants::VARINT) == WIRE_TYPE && ((1 == FIELD) || (6 == FIELD))) {
+            if (!readVarInt(pos, end, value)) {
+                return false;
+            }
+            if (1 == FIELD) {
+                view.m_dataType = fromZigZag32(value);
+            } else {
+                view.m_senderStamp = static_cast<uint32_t>(value);
+            }
+        } else if ((static_cast<uint8_t>(cluon::ProtoConstants::LENGTH_DELIMITED) == WIRE_TYPE) && (2 <= FIELD) && (FIELD <= 5)) {
+            if (!readVarInt(pos, end, value) || (value > static_cast<uint64_t>(end - pos))) {
+                return false;
+            }
+            if (2 == FIELD) {
+                view.m_serializedData = reinterpret_cast<const char*>(pos);
+                view.m_serializedDataLength = static_cast<std::size_t>(value);
+            } else {
+                cluon::data::TimeStamp& ts { (3 == FIELD) ? view.m_sent : ((4 == FIELD) ? view.m_received : view.m_sampleTimeStamp) };
+                if (!parseTimeStamp(pos, pos + value, ts)) {
+                    return false;
+                }
+            }
+            pos += value;
+        } else if (!skipField(pos, end, WIRE_TYPE)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+std::size_t parseFrame(const char* data, std::size_t available, EnvelopeView& view) noexcept {
+    uint32_t length { 0 };
+    if (!parseOD4Header(data, available, length) || (available - OD4_HEADER_SIZE < length)) {
+        return 0;
+    }
+    return parseEnvelope(data + OD4_HEADER_SIZE, length, view) ? OD4_HEADER_SIZE + length : 0;
+}
+
+cluon::data::Envelope toEnvelope(const EnvelopeView& view) {
+    cluon::data::Envelope env;
+    env.dataType(view.m_dataType)
+        .serializedData(std::string(view.m_serializedData, view.m_serializedDataLength))
+        .sent(view.m_sent)
+        .received(view.m_received)
+        .sampleTimeStamp(view.m_sampleTimeStamp)
+        .senderStamp(view.m_senderStamp);
+    return env;
+}
+
+MemoryStreamBuffer::MemoryStreamBuffer(const char* data, std::size_t length) {
+    // std::streambuf wants non-const pointers but never writes through the get area.
+    char* begin { const_cast<char*>(data) };
+    setg(begin, begin, begin + length);
+}
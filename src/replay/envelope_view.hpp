@@ -0,0 +1,56 @@
+// Lightweight, non-owning view of an OD4 frame
+//    0x0D 0xA4 LEN0 LEN1 LEN2 Proto-encoded cluon::data::Envelope
+// whose payload points into the memory the frame was parsed from.
+#ifndef ENVELOPE_VIEW_H
+#define ENVELOPE_VIEW_H
+
+#include "cluon-complete.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <istream>
+#include <streambuf>
+
+struct EnvelopeView {
+    int32_t m_dataType { 0 };
+    const char* m_serializedData { nullptr };
+    std::size_t m_serializedDataLength { 0 };
+    cluon::data::TimeStamp m_sent {};
+    cluon::data::TimeStamp m_received {};
+    cluon::data::TimeStamp m_sampleTimeStamp {};
+    uint32_t m_senderStamp { 0 };
+};
+
+constexpr std::size_t OD4_HEADER_SIZE { 5 };
+
+// Returns the payload length announced by an OD4 header, or false if data is no OD4 header.
+bool parseOD4Header(const char* data, std::size_t available, uint32_t& length) noexcept;
+
+// Parses the proto-encoded Envelope in [data, data + length) without copying the payload.
+bool parseEnvelope(const char* data, std::size_t length, EnvelopeView& view) noexcept;
+
+// Parses a complete OD4 frame; returns the frame's size or 0 if it is truncated or invalid.
+std::size_t parseFrame(const char* data, std::size_t available, EnvelopeView& view) noexcept;
+
+// Copies the view into a regular Envelope.
+cluon::data::Envelope toEnvelope(const EnvelopeView& view);
+
+// Read-only std::streambuf over existing memory.
+class MemoryStreamBuffer : public std::streambuf {
+   public:
+    MemoryStreamBuffer(const char* data, std::size_t length);
+};
+
+// Decodes the view's payload straight from the underlying memory.
+template <typename T>
+T extractMessage(const EnvelopeView& view) noexcept {
+    MemoryStreamBuffer buffer(view.m_serializedData, view.m_serializedDataLength);
+    std::istream in(&buffer);
+    cluon::FromProtoVisitor decoder;
+    decoder.decodeFrom(in);
+
+    T msg;
+    msg.accept(decoder);
+    return msg;
+}
+
+#endif
@@ -0,0 +1,118 @@
+#include "frame_replay.hpp"
+#include "opendlv-standard-message-set.hpp"
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <unistd.h>
+
+namespace {
+// True if the Annex B stream contains a sequence parameter set (NAL unit type 7).
+bool hasSequenceParameterSet(const std::string& data) noexcept {
+    for (std::size_t i { 0 }; i + 3 < data.size(); i++) {
+        if ((0 == data[i]) && (0 == data[i + 1]) && (1 == data[i + 2]) && (7 == (data[i + 3] & 0x1f))) {
+            return true;
+        }
+    }
+    return false;
+}
+}
+
+FrameReplay::FrameReplay(const std::string& file, const std::vector<EnvelopeFilter>& filter, RecordingPlayer::Source source)
+    : m_file(file)
+    , m_filter(filter)
+    , m_source(source)
+    , m_valid(false)
+    , m_videoFile()
+    , m_numberOfFrames(0)
+    , m_numberOfUndecodableFrames(0)
+    , m_video()
+    , m_image() {
+    m_filter.push_back(EnvelopeFilter { opendlv::proxy::ImageReading::ID() });
+    m_valid = extractVideo(source);
+}
+
+FrameReplay::~FrameReplay() {
+    m_video.release();
+    if (!m_videoFile.empty()) {
+        ::unlink(m_videoFile.c_str());
+    }
+}
+
+bool FrameReplay::valid() const noexcept {
+    return m_valid;
+}
+
+uint32_t FrameReplay::numberOfFrames() const noexcept {
+    return m_numberOfFrames;
+}
+
+uint32_t FrameReplay::numberOfUndecodableFrames() const noexcept {
+    return m_numberOfUndecodableFrames;
+}
+
+bool FrameReplay::extractVideo(RecordingPlayer::Source source) {
+    RecordingPlayer player { m_file, false, { EnvelopeFilter { opendlv::proxy::ImageReading::ID() } }, source };
+    if (0 == player.totalNumberOfEnvelopesInRecFile()) {
+        return false;
+    }
+    std::string videoFile { "/tmp/frame-replay-XXXXXX.h264" };
+    const int FD { ::mkstemps(&videoFile[0], 5) };
+    if (-1 == FD) {
+        std::cerr << "[FrameReplay]: Cannot create a file for the video of " << m_file << "." << std::endl;
+        return false;
+    }
+    ::close(FD);
+    m_videoFile = videoFile;
+
+    std::ofstream video(m_videoFile, std::ios::binary | std::ios::trunc);
+    bool decodable { false };
+    while (player.hasMoreData()) {
+        auto next = player.getNextEnvelopeViewToBeReplayed();
+        if (!next.first) {
+            break;
+        }
+        m_numberOfFrames++;
+        const auto IMAGE { extractMessage<opendlv::proxy::ImageReading>(next.second) };
+        decodable = decodable || (("h264" == IMAGE.fourcc()) && hasSequenceParameterSet(IMAGE.data()));
+        if (decodable) {
+            video.write(IMAGE.data().data(), static_cast<std::streamsize>(IMAGE.data().size()));
+        } else {
+            m_numberOfUndecodableFrames++;
+        }
+    }
+    return video.good();
+}
+
+bool FrameReplay::run(const FrameDelegate& onFrame, const EnvelopeDelegate& onEnvelope) {
+    if (!m_valid) {
+        return false;
+    }
+    m_video.release();
+    if ((m_numberOfUndecodableFrames < m_numberOfFrames) && !m_video.open(m_videoFile)) {
+        std::cerr << "[FrameReplay]: Cannot decode the video of " << m_file << "." << std::endl;
+        return false;
+    }
+
+    const cv::Mat NO_IMAGE;
+    RecordingPlayer player { m_file, false, m_filter, m_source };
+    uint32_t frame { 0 };
+    while (player.hasMoreData()) {
+        // The images' payload is in the video already; only the other
+        // envelopes are materialized.
+        auto next = player.getNextEnvelopeViewToBeReplayed();
+        if (!next.first) {
+            break;
+        }
+        const EnvelopeView& view = next.second;
+        if (opendlv::proxy::ImageReading::ID() != view.m_dataType) {
+            onEnvelope(toEnvelope(view));
+            continue;
+        }
+        // Each ImageReading from the entry point on decodes to exactly one image.
+        const bool DECODED { (frame++ >= m_numberOfUndecodableFrames) && m_video.read(m_image) };
+        if (!onFrame(view.m_sampleTimeStamp, DECODED ? m_image : NO_IMAGE)) {
+            break;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,61 @@
+// Replays the camera frames of a recording: every ImageReading is handed on
+// with its decoded image, all other selected envelopes as they are, in
+// recorded order. The h264 stream is gathered from the ImageReadings first and
+// then decoded by cv::VideoCapture while replaying, one image per
+// ImageReading; ImageReadings before the first one with a sequence parameter
+// set (the decoder's entry point) come with an empty image.
+#ifndef FRAME_REPLAY_H
+#define FRAME_REPLAY_H
+
+#include <replay/recording_player.hpp>
+#include <opencv2/core/core.hpp>
+#include <opencv2/videoio/videoio.hpp>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+class FrameReplay {
+   private:
+    FrameReplay(const FrameReplay&) = delete;
+    FrameReplay(FrameReplay&&) = delete;
+    FrameReplay& operator=(const FrameReplay&) = delete;
+    FrameReplay& operator=(FrameReplay&&) = delete;
+
+   public:
+    // Gets a frame's sample time stamp and its BGR image, which is valid until
+    // the next frame; returning false ends the replay.
+    using FrameDelegate = std::function<bool(const cluon::data::TimeStamp& sampleTimeStamp, const cv::Mat& image)>;
+    using EnvelopeDelegate = std::function<void(cluon::data::Envelope&& envelope)>;
+
+    // filter selects the envelopes replayed besides the ImageReadings.
+    FrameReplay(const std::string& file, const std::vector<EnvelopeFilter>& filter, RecordingPlayer::Source source = RecordingPlayer::Source::MAPPED);
+    ~FrameReplay();
+
+    // False if the recording could not be read.
+    bool valid() const noexcept;
+    uint32_t numberOfFrames() const noexcept;
+    // Frames without an image as they precede the stream's entry point.
+    uint32_t numberOfUndecodableFrames() const noexcept;
+
+    // Replays from the start until the end or until onFrame returns false;
+    // returns false if the video could not be decoded.
+    bool run(const FrameDelegate& onFrame, const EnvelopeDelegate& onEnvelope);
+
+   private:
+    bool extractVideo(RecordingPlayer::Source source);
+
+   private:
+    std::string m_file;
+    std::vector<EnvelopeFilter> m_filter;
+    RecordingPlayer::Source m_source;
+    bool m_valid;
+    // The ImageReadings' h264 stream from the entry point on; removed again.
+    std::string m_videoFile;
+    uint32_t m_numberOfFrames;
+    uint32_t m_numberOfUndecodableFrames;
+    cv::VideoCapture m_video;
+    cv::Mat m_image;
+};
+
+#endif
@@ -0,0 +1,90 @@
+#include "mapped_recording.hpp"
+#include <fcntl.h>
+#include <iostream>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+MappedRecording::MappedRecording(const std::string& recFile)
+    : m_fd(-1)
+    , m_data(nullptr)
+    , m_size(0) {
+    m_fd = ::open(recFile.c_str(), O_RDONLY | O_CLOEXEC);
+    struct stat st {};
+    if ((-1 == m_fd) || (0 != ::fstat(m_fd, &st)) || (0 >= st.st_size)) {
+        std::clog << "[MappedRecording]: " << recFile << " could not be opened." << std::endl;
+        return;
+    }
+
+    void* addr = ::mmap(nullptr, static_cast<std::size_t>(st.st_size), PROT_READ, MAP_PRIVATE, m_fd, 0);
+    if (MAP_FAILED == addr) {
+        std::clog << "[MappedRecording]: " << recFile << " could not be mapped." << std::endl;
+        return;
+    }
+    m_data = static_cast<const char*>(addr);
+    m_size = static_cast<uint64_t>(st.st_size);
+    adviseSequential();
+}
+
+MappedRecording::~MappedRecording() {
+    if (nullptr != m_data) {
+        ::munmap(const_cast<char*>(m_data), static_cast<std::size_t>(m_size));
+    }
+    if (-1 != m_fd) {
+        ::close(m_fd);
+    }
+}
+
+bool MappedRecording::valid() const noexcept {
+    return nullptr != m_data;
+}
+
+const char* MappedRecording::data() const noexcept {
+    return m_data;
+}
+
+uint64_t MappedRecording::size() const noexcept {
+    return m_size;
+}
+
+bool MappedRecording::viewAt(uint64_t filePosition, EnvelopeView& view) const noexcept {
+    return (filePosition < m_size) && (0 < parseFrame(m_data + filePosition, static_cast<std::size_t>(m_size - filePosition), view));
+}
+
+bool MappedRecording::viewAt(const RecordingIndexEntry& entry, EnvelopeView& view) const noexcept {
+    return viewAt(entry.m_filePosition, view);
+}
+
+void MappedRecording::adviseSequential() const noexcept {
+    if (nullptr != m_data) {
+        ::madvise(const_cast<char*>(m_data), static_cast<std::size_t>(m_size), MADV_SEQUENTIAL);
+    }
+}
+
+void MappedRecording::adviseRandom() const noexcept {
+    if (nullptr != m_data) {
+        ::madvise(const_cast<char*>(m_data), static_cast<std::size_t>(m_size), MADV_RANDOM);
+    }
+}
+
+void MappedRecording::adviseWillNeed(uint64_t filePosition, uint64_t length) const noexcept {
+    if ((nullptr != m_data) && (filePosition < m_size)) {
+        // madvise needs a page-aligned start.
+        const uint64_t PAGE_SIZE { static_cast<uint64_t>(::sysconf(_SC_PAGESIZE)) };
+        const uint64_t START { filePosition & ~(PAGE_SIZE - 1) };
+        const uint64_t END { (filePosition + length < m_size) ? filePosition + length : m_size };
+        ::madvise(const_cast<char*>(m_data) + START, static_cast<std::size_t>(END - START), MADV_WILLNEED);
+    }
+}
+
+void MappedRecording::release(uint64_t filePosition, uint64_t length) const noexcept {
+    if ((nullptr != m_data) && (filePosition < m_size)) {
+        // Only whole pages inside the range are released.
+        const uint64_t PAGE_SIZE { static_cast<uint64_t>(::sysconf(_SC_PAGESIZE)) };
+        const uint64_t START { (filePosition + PAGE_SIZE - 1) & ~(PAGE_SIZE - 1) };
+        const uint64_t END { ((filePosition + length < m_size) ? filePosition + length : m_size) & ~(PAGE_SIZE - 1) };
+        if (START < END) {
+            ::madvise(const_cast<char*>(m_data) + START, static_cast<std::size_t>(END - START), MADV_DONTNEED);
+        }
+    }
+}
@@ -0,0 +1,59 @@
+// Read-only, memory-mapped .rec file handing out EnvelopeViews into the mapping.
+#ifndef MAPPED_RECORDING_H
+#define MAPPED_RECORDING_H
+
+#include <replay/envelope_view.hpp>
+#include <replay/recording_index.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+class MappedRecording {
+   private:
+    MappedRecording(const MappedRecording&) = delete;
+    MappedRecording(MappedRecording&&) = delete;
+    MappedRecording& operator=(const MappedRecording&) = delete;
+    MappedRecording& operator=(MappedRecording&&) = delete;
+
+   public:
+    // The mapping is advised for sequential access by default.
+    explicit MappedRecording(const std::string& recFile);
+    ~MappedRecording();
+
+    bool valid() const noexcept;
+    const char* data() const noexcept;
+    uint64_t size() const noexcept;
+
+    // View of the envelope starting at filePosition; valid as long as this object lives.
+    bool viewAt(uint64_t filePosition, EnvelopeView& view) const noexcept;
+    bool viewAt(const RecordingIndexEntry& entry, EnvelopeView& view) const noexcept;
+
+    // Visits all envelopes in file order until the delegate returns false.
+    template <typename F>
+    void forEachEnvelope(F&& delegate) const {
+        uint64_t pos { 0 };
+        EnvelopeView view;
+        while (pos < m_size) {
+            const std::size_t FRAME_SIZE { parseFrame(m_data + pos, static_cast<std::size_t>(m_size - pos), view) };
+            if ((0 == FRAME_SIZE) || !delegate(pos, view)) {
+                break;
+            }
+            pos += FRAME_SIZE;
+        }
+    }
+
+    // Access pattern hints for the kernel's read-ahead.
+    void adviseSequential() const noexcept;
+    void adviseRandom() const noexcept;
+    void adviseWillNeed(uint64_t filePosition, uint64_t length) const noexcept;
+    // Drops resident pages of the given range; views into it stay valid and
+    // fault the data back in from the file when accessed again.
+    void release(uint64_t filePosition, uint64_t length) const noexcept;
+
+   private:
+    int m_fd;
+    const char* m_data;
+    uint64_t m_size;
+};
+
+#endif
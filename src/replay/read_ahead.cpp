@@ -0,0 +1,367 @@
+#include "read_ahead.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <iostream>
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+namespace {
+int ioUringSetup(unsigned entries, struct io_uring_params* params) noexcept {
+    return static_cast<int>(::syscall(__NR_io_uring_setup, entries, params));
+}
+
+int ioUringEnter(int fd, unsigned toSubmit, unsigned minComplete, unsigned flags) noexcept {
+    return static_cast<int>(::syscall(__NR_io_uring_enter, fd, toSubmit, minComplete, flags, nullptr, 0));
+}
+
+unsigned loadAcquire(const unsigned* p) noexcept {
+    return __atomic_load_n(p, __ATOMIC_ACQUIRE);
+}
+
+void storeRelease(unsigned* p, unsigned v) noexcept {
+    __atomic_store_n(p, v, __ATOMIC_RELEASE);
+}
+}
+
+constexpr std::size_t ReadAheadEngine::DEFAULT_BYTE_BUDGET;
+
+ReadAheadEngine::ReadAheadEngine(const std::string& file, const std::vector<RecordingIndexEntry>& entries, std::size_t byteBudget, uint32_t depth)
+    : m_fd(-1)
+    , m_entries(entries)
+    , m_slots((0 < depth) ? depth : 1)
+    , m_iovecs(m_slots.size())
+    , m_buffer()
+    , m_readOffset(0)
+    , m_writeOffset(0)
+    , m_used(0)
+    , m_buffered(0)
+    , m_metrics()
+    , m_next(0)
+    , m_nextToSubmit(0)
+    , m_lentSlot(-1)
+    , m_ringFd(-1)
+    , m_sqRing(nullptr)
+    , m_sqRingSize(0)
+    , m_cqRing(nullptr)
+    , m_cqRingSize(0)
+    , m_sqes(nullptr)
+    , m_sqesSize(0)
+    , m_sqHead(nullptr)
+    , m_sqTail(nullptr)
+    , m_sqMask(nullptr)
+    , m_sqArray(nullptr)
+    , m_cqHead(nullptr)
+    , m_cqTail(nullptr)
+    , m_cqMask(nullptr)
+    , m_cqes(nullptr)
+    , m_toSubmit(0)
+    , m_inFlight(0) {
+    m_fd = ::open(file.c_str(), O_RDONLY | O_CLOEXEC);
+    if (-1 == m_fd) {
+        std::clog << "[ReadAheadEngine]: " << file << " could not be opened." << std::endl;
+        return;
+    }
+    std::size_t largestFrame { 0 };
+    for (const auto& e : m_entries) {
+        largestFrame = (e.m_length > largestFrame) ? e.m_length : largestFrame;
+    }
+    if (largestFrame > byteBudget) {
+        std::clog << "[ReadAheadEngine]: Raising byte budget from " << byteBudget << " to " << largestFrame << " bytes to hold the largest frame." << std::endl;
+    }
+    m_buffer.resize((largestFrame > byteBudget) ? largestFrame : byteBudget);
+    if (!setupIoUring(static_cast<uint32_t>(m_slots.size()))) {
+        std::clog << "[ReadAheadEngine]: io_uring not available (" << std::strerror(errno) << "); using pread." << std::endl;
+    }
+    seek(0);
+}
+
+ReadAheadEngine::~ReadAheadEngine() {
+    drain();
+    teardownIoUring();
+    if (-1 != m_fd) {
+        ::close(m_fd);
+    }
+}
+
+bool ReadAheadEngine::valid() const noexcept {
+    return -1 != m_fd;
+}
+
+bool ReadAheadEngine::usesIoUring() const noexcept {
+    return -1 != m_ringFd;
+}
+
+std::size_t ReadAheadEngine::byteBudget() const noexcept {
+    return m_buffer.size();
+}
+
+ReplayCacheMetrics ReadAheadEngine::metrics() const noexcept {
+    return m_metrics;
+}
+
+bool ReadAheadEngine::setupIoUring(uint32_t depth) noexcept {
+    struct io_uring_params params;
+    std::memset(&params, 0, sizeof(params));
+    m_ringFd = ioUringSetup(depth, &params);
+    if (0 > m_ringFd) {
+        m_ringFd = -1;
+        return false;
+    }
+
+    m_sqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    m_cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    const bool SINGLE_MMAP { 0 != (params.features & IORING_FEAT_SINGLE_MMAP) };
+    if (SINGLE_MMAP) {
+        m_sqRingSize = m_cqRingSize = (m_sqRingSize > m_cqRingSize) ? m_sqRingSize : m_cqRingSize;
+    }
+    m_sqRing = ::mmap(nullptr, m_sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_ringFd, IORING_OFF_SQ_RING);
+    m_cqRing = SINGLE_MMAP ? m_sqRing : ::mmap(nullptr, m_cqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_ringFd, IORING_OFF_CQ_RING);
+    m_sqesSize = params.sq_entries * sizeof(struct io_uring_sqe);
+    m_sqes = ::mmap(nullptr, m_sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_ringFd, IORING_OFF_SQES);
+    if ((MAP_FAILED == m_sqRing) || (MAP_FAILED == m_cqRing) || (MAP_FAILED == m_sqes)) {
+        m_sqRing = (MAP_FAILED == m_sqRing) ? nullptr : m_sqRing;
+        m_cqRing = (MAP_FAILED == m_cqRing) ? nullptr : m_cqRing;
+        m_sqes = (MAP_FAILED == m_sqes) ? nullptr : m_sqes;
+        teardownIoUring();
+        return false;
+    }
+
+    char* sq { static_cast<char*>(m_sqRing) };
+    char* cq { static_cast<char*>(m_cqRing) };
+    m_sqHead = reinterpret_cast<unsigned*>(sq + params.sq_off.head);
+    m_sqTail = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+    m_sqMask = reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+    m_sqArray = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+    m_cqHead = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+    m_cqTail = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+    m_cqMask = reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+    m_cqes = cq + params.cq_off.cqes;
+    return true;
+}
+
+void ReadAheadEngine::teardownIoUring() noexcept {
+    if (nullptr != m_sqes) {
+        ::munmap(m_sqes, m_sqesSize);
+    }
+    if ((nullptr != m_cqRing) && (m_cqRing != m_sqRing)) {
+        ::munmap(m_cqRing, m_cqRingSize);
+    }
+    if (nullptr != m_sqRing) {
+        ::munmap(m_sqRing, m_sqRingSize);
+    }
+    m_sqes = m_cqRing = m_sqRing = nullptr;
+    if (-1 != m_ringFd) {
+        ::close(m_ringFd);
+        m_ringFd = -1;
+    }
+}
+
+bool ReadAheadEngine::allocate(std::size_t length, std::size_t& offset, std::size_t& allocated) noexcept {
+    const std::size_t SIZE { m_buffer.size() };
+    if (0 == m_used) {
+        m_readOffset = m_writeOffset = 0;
+    }
+    const bool WRAP { (m_writeOffset >= m_readOffset) && (m_writeOffset + length > SIZE) };
+    offset = WRAP ? 0 : m_writeOffset;
+    allocated = (WRAP ? SIZE - m_writeOffset : 0) + length;
+    if ((m_used + allocated > SIZE) || (WRAP && (length > m_readOffset))) {
+        return false;
+    }
+    m_writeOffset = offset + length;
+    m_used += allocated;
+    m_metrics.m_residentBytes = m_used;
+    m_metrics.m_peakResidentBytes = (m_used > m_metrics.m_peakResidentBytes) ? m_used : m_metrics.m_peakResidentBytes;
+    return true;
+}
+
+void ReadAheadEngine::evictOldest(const Slot& slot) noexcept {
+    m_readOffset = slot.m_offset + m_entries[slot.m_entry].m_length;
+    m_used -= slot.m_allocated;
+    m_buffered--;
+    m_metrics.m_residentBytes = m_used;
+    m_metrics.m_evictedBytes += m_entries[slot.m_entry].m_length;
+}
+
+void ReadAheadEngine::fill() noexcept {
+    while ((m_nextToSubmit < m_entries.size()) && (m_buffered < m_slots.size())) {
+        const uint32_t SLOT { static_cast<uint32_t>(m_nextToSubmit % m_slots.size()) };
+        if (!allocate(m_entries[m_nextToSubmit].m_length, m_slots[SLOT].m_offset, m_slots[SLOT].m_allocated)) {
+            break;
+        }
+        submit(SLOT, m_nextToSubmit);
+        m_buffered++;
+        m_nextToSubmit++;
+    }
+    flush();
+}
+
+void ReadAheadEngine::submit(uint32_t slot, std::size_t entry) noexcept {
+    Slot& s = m_slots[slot];
+    s.m_entry = entry;
+    s.m_completed = false;
+    s.m_result = 0;
+    const RecordingIndexEntry& e = m_entries[entry];
+    char* buffer { m_buffer.data() + s.m_offset };
+
+    if (-1 == m_ringFd) {
+        // Without io_uring the read happens right away.
+        readSynchronously(slot);
+        return;
+    }
+
+    m_iovecs[slot].iov_base = buffer;
+    m_iovecs[slot].iov_len = e.m_length;
+
+    const unsigned TAIL { *m_sqTail };
+    const unsigned INDEX { TAIL & *m_sqMask };
+    struct io_uring_sqe* sqe { static_cast<struct io_uring_sqe*>(m_sqes) + INDEX };
+    std::memset(sqe, 0, sizeof(struct io_uring_sqe));
+    sqe->opcode = IORING_OP_READV;
+    sqe->fd = m_fd;
+    sqe->off = e.m_filePosition;
+    sqe->addr = reinterpret_cast<uint64_t>(&m_iovecs[slot]);
+    sqe->len = 1;
+    sqe->user_data = slot;
+    m_sqArray[INDEX] = INDEX;
+    storeRelease(m_sqTail, TAIL + 1);
+
+    s.m_inFlight = true;
+    m_toSubmit++;
+    m_inFlight++;
+}
+
+void ReadAheadEngine::readSynchronously(uint32_t slot) noexcept {
+    Slot& s = m_slots[slot];
+    const RecordingIndexEntry& e = m_entries[s.m_entry];
+    const ssize_t N { ::pread(m_fd, m_buffer.data() + s.m_offset, e.m_length, static_cast<off_t>(e.m_filePosition)) };
+    s.m_result = static_cast<int32_t>((0 > N) ? -errno : N);
+    s.m_inFlight = false;
+    s.m_completed = true;
+}
+
+int ReadAheadEngine::enter(uint32_t toSubmit, bool wait) noexcept {
+    int result { -1 };
+    do {
+        result = ioUringEnter(m_ringFd, toSubmit, wait ? 1 : 0, wait ? IORING_ENTER_GETEVENTS : 0);
+    } while ((0 > result) && (EINTR == errno));
+    return result;
+}
+
+void ReadAheadEngine::flush() noexcept {
+    if ((-1 == m_ringFd) || (0 == m_toSubmit)) {
+        return;
+    }
+    const int SUBMITTED { enter(m_toSubmit, false) };
+    if (0 <= SUBMITTED) {
+        m_toSubmit -= (std::min)(m_toSubmit, static_cast<uint32_t>(SUBMITTED));
+        return;
+    }
+    // Out of resources: try again once reads in flight have completed.
+    if (((EAGAIN == errno) || (EBUSY == errno)) && (m_inFlight > m_toSubmit)) {
+        return;
+    }
+    std::clog << "[ReadAheadEngine]: Submitting " << m_toSubmit << " reads failed (" << std::strerror(errno) << "); using pread for them." << std::endl;
+    readUnsubmitted();
+}
+
+void ReadAheadEngine::readUnsubmitted() noexcept {
+    // The kernel consumes SQEs in order, so the unsubmitted ones are the newest;
+    // they are taken back from the ring and read right away.
+    const unsigned TAIL { *m_sqTail };
+    for (unsigned i { TAIL - m_toSubmit }; i != TAIL; i++) {
+        const struct io_uring_sqe* sqe { static_cast<const struct io_uring_sqe*>(m_sqes) + m_sqArray[i & *m_sqMask] };
+        readSynchronously(static_cast<uint32_t>(sqe->user_data));
+        m_inFlight--;
+    }
+    storeRelease(m_sqTail, TAIL - m_toSubmit);
+    m_toSubmit = 0;
+}
+
+void ReadAheadEngine::reap(bool wait) noexcept {
+    if (-1 == m_ringFd) {
+        return;
+    }
+    if (wait) {
+        flush();
+        // Only reads the kernel has accepted can complete; after a failed wait,
+        // the completion queue is checked again by the caller's loop.
+        if (m_inFlight > m_toSubmit) {
+            enter(0, true);
+        }
+    }
+    unsigned head { *m_cqHead };
+    const unsigned TAIL { loadAcquire(m_cqTail) };
+    while (head != TAIL) {
+        const struct io_uring_cqe* cqe { static_cast<const struct io_uring_cqe*>(m_cqes) + (head & *m_cqMask) };
+        Slot& s = m_slots[static_cast<std::size_t>(cqe->user_data)];
+        s.m_result = cqe->res;
+        s.m_inFlight = false;
+        s.m_completed = true;
+        m_inFlight--;
+        head++;
+    }
+    storeRelease(m_cqHead, head);
+}
+
+void ReadAheadEngine::drain() noexcept {
+    flush();
+    while (0 < m_inFlight) {
+        reap(true);
+    }
+}
+
+void ReadAheadEngine::seek(std::size_t entry) noexcept {
+    // Buffers of reads still in flight must not be reused before they complete.
+    drain();
+    m_next = m_nextToSubmit = (entry < m_entries.size()) ? entry : m_entries.size();
+    m_lentSlot = -1;
+    m_metrics.m_evictedBytes += m_used;
+    m_metrics.m_residentBytes = m_used = m_buffered = 0;
+    if (-1 == m_fd) {
+        return;
+    }
+    fill();
+}
+
+bool ReadAheadEngine::next(EnvelopeView& view) noexcept {
+    if (-1 == m_fd) {
+        return false;
+    }
+    // The previously handed out frame is the oldest one; its space goes to
+    // the entries to read ahead.
+    if (0 <= m_lentSlot) {
+        evictOldest(m_slots[static_cast<std::size_t>(m_lentSlot)]);
+        m_lentSlot = -1;
+    }
+    fill();
+    if (m_next >= m_entries.size()) {
+        return false;
+    }
+
+    const uint32_t SLOT { static_cast<uint32_t>(m_next % m_slots.size()) };
+    Slot& s = m_slots[SLOT];
+    reap(false);
+    if (s.m_completed) {
+        m_metrics.m_hits++;
+    } else {
+        m_metrics.m_misses++;
+    }
+    while (!s.m_completed) {
+        reap(true);
+    }
+
+    const RecordingIndexEntry& e = m_entries[m_next];
+    if ((0 <= s.m_result) && (static_cast<uint32_t>(s.m_result) < e.m_length)) {
+        // Complete short reads synchronously.
+        const ssize_t N { ::pread(m_fd, m_buffer.data() + s.m_offset + s.m_result, e.m_length - static_cast<uint32_t>(s.m_result), static_cast<off_t>(e.m_filePosition) + s.m_result) };
+        s.m_result = (0 < N) ? s.m_result + static_cast<int32_t>(N) : -EIO;
+    }
+    m_lentSlot = SLOT;
+    m_next++;
+    return (static_cast<int64_t>(e.m_length) == s.m_result) && (0 < parseFrame(m_buffer.data() + s.m_offset, e.m_length, view));
+}
@@ -0,0 +1,120 @@
+// Read-ahead engine that keeps many reads for upcoming index entries in flight
+// through io_uring and completes them into a ring buffer of a fixed byte budget;
+// the oldest frames are evicted first as replay moves on. Falls back to
+// synchronous pread when io_uring is not available (old kernel, seccomp).
+#ifndef READ_AHEAD_H
+#define READ_AHEAD_H
+
+#include <replay/envelope_view.hpp>
+#include <replay/recording_index.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+struct iovec;
+
+// Replay cache statistics; hits and misses count entries whose read had or had
+// not yet completed when they were requested.
+struct ReplayCacheMetrics {
+    uint64_t m_hits { 0 };
+    uint64_t m_misses { 0 };
+    uint64_t m_residentBytes { 0 };
+    uint64_t m_peakResidentBytes { 0 };
+    uint64_t m_evictedBytes { 0 };
+};
+
+class ReadAheadEngine {
+   private:
+    ReadAheadEngine(const ReadAheadEngine&) = delete;
+    ReadAheadEngine(ReadAheadEngine&&) = delete;
+    ReadAheadEngine& operator=(const ReadAheadEngine&) = delete;
+    ReadAheadEngine& operator=(ReadAheadEngine&&) = delete;
+
+   public:
+    static constexpr std::size_t DEFAULT_BYTE_BUDGET { 64 * 1024 * 1024 };
+
+    // entries must outlive the engine. At most depth entries and byteBudget bytes
+    // are buffered; the budget is raised to the largest frame if that is bigger.
+    ReadAheadEngine(const std::string& file, const std::vector<RecordingIndexEntry>& entries, std::size_t byteBudget = DEFAULT_BYTE_BUDGET, uint32_t depth = 64);
+    ~ReadAheadEngine();
+
+    bool valid() const noexcept;
+    bool usesIoUring() const noexcept;
+    std::size_t byteBudget() const noexcept;
+    ReplayCacheMetrics metrics() const noexcept;
+
+    // Restarts reading at the given entry; reads still in flight are discarded.
+    void seek(std::size_t entry) noexcept;
+
+    // Frame of the next entry, waiting for its read if needed; the view is valid
+    // until the following call to next() or seek().
+    bool next(EnvelopeView& view) noexcept;
+
+   private:
+    struct Slot {
+        std::size_t m_entry { 0 };
+        std::size_t m_offset { 0 };
+        std::size_t m_allocated { 0 };
+        bool m_inFlight { false };
+        bool m_completed { false };
+        int32_t m_result { 0 };
+    };
+
+    bool setupIoUring(uint32_t depth) noexcept;
+    void teardownIoUring() noexcept;
+    bool allocate(std::size_t length, std::size_t& offset, std::size_t& allocated) noexcept;
+    void evictOldest(const Slot& slot) noexcept;
+    void fill() noexcept;
+    void submit(uint32_t slot, std::size_t entry) noexcept;
+    void readSynchronously(uint32_t slot) noexcept;
+    // io_uring_enter, retried when interrupted; returns the number of SQEs submitted or -1.
+    int enter(uint32_t toSubmit, bool wait) noexcept;
+    void flush() noexcept;
+    void readUnsubmitted() noexcept;
+    void reap(bool wait) noexcept;
+    void drain() noexcept;
+
+   private:
+    int m_fd;
+    const std::vector<RecordingIndexEntry>& m_entries;
+    std::vector<Slot> m_slots;
+    std::vector<struct iovec> m_iovecs;
+
+    // Frames are placed back to back; a frame not fitting at the end wraps to
+    // the start and the remainder is accounted to it.
+    std::vector<char> m_buffer;
+    std::size_t m_readOffset;
+    std::size_t m_writeOffset;
+    std::size_t m_used;
+    std::size_t m_buffered;
+    ReplayCacheMetrics m_metrics;
+
+    // Next entry to hand out and next entry to submit.
+    std::size_t m_next;
+    std::size_t m_nextToSubmit;
+    // Slot handed out by the last next(); recycled on the following call.
+    int64_t m_lentSlot;
+
+    // io_uring state; m_ringFd is -1 when falling back to pread.
+    int m_ringFd;
+    void* m_sqRing;
+    std::size_t m_sqRingSize;
+    void* m_cqRing;
+    std::size_t m_cqRingSize;
+    void* m_sqes;
+    std::size_t m_sqesSize;
+    unsigned* m_sqHead;
+    unsigned* m_sqTail;
+    unsigned* m_sqMask;
+    unsigned* m_sqArray;
+    unsigned* m_cqHead;
+    unsigned* m_cqTail;
+    unsigned* m_cqMask;
+    void* m_cqes;
+    // SQEs queued in the ring but not yet accepted by the kernel.
+    uint32_t m_toSubmit;
+    uint32_t m_inFlight;
+};
+
+#endif
@@ -0,0 +1,460 @@
+#include "recording_index.hpp"
+#include "cluon-complete.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <fcntl.h>
+#include <fstream>
+#include <iostream>
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
+
+namespace {
+// Sidecar layout (native byte order): header, then one column per field.
+const char SIDECAR_MAGIC[8] = { 'R', 'E', 'C', 'I', 'D', 'X', '0', '2' };
+const uint32_t SIDECAR_BYTE_ORDER { 0x01020304 };
+
+struct SidecarHeader {
+    char m_magic[8];
+    uint32_t m_byteOrder;
+    uint32_t m_reserved;
+    uint64_t m_numberOfEntries;
+    uint64_t m_recFileSize;
+    int64_t m_recFileModificationTime;
+};
+
+template <typename T>
+void writeColumn(std::ostream& out, const std::vector<RecordingIndexEntry>& entries, T RecordingIndexEntry::*field) {
+    std::vector<T> column;
+    column.reserve(entries.size());
+    for (const auto& e : entries) {
+        column.push_back(e.*field);
+    }
+    out.write(reinterpret_cast<const char*>(column.data()), static_cast<std::streamsize>(column.size() * sizeof(T)));
+}
+
+// Sequential reader over a file in large chunks that can skip bytes without reading them.
+class ChunkedFileReader {
+   public:
+    static constexpr std::size_t CHUNK_SIZE { 8 * 1024 * 1024 };
+
+    ChunkedFileReader(int fd, uint64_t position)
+        : m_fd(fd)
+        , m_buffer(CHUNK_SIZE)
+        , m_bufferPosition(position)
+        , m_begin(0)
+        , m_end(0)
+        , m_bytesRead(0) {
+    }
+
+    uint64_t position() const noexcept {
+        return m_bufferPosition + m_begin;
+    }
+
+    uint64_t bytesRead() const noexcept {
+        return m_bytesRead;
+    }
+
+    bool read(uint8_t& b) noexcept {
+        if ((m_begin == m_end) && !refill()) {
+            return false;
+        }
+        b = static_cast<uint8_t>(m_buffer[m_begin++]);
+        return true;
+    }
+
+    // Skips within the buffer or, for larger distances, moves the file position.
+    bool skip(uint64_t n) noexcept {
+        if (n <= m_end - m_begin) {
+            m_begin += static_cast<std::size_t>(n);
+            return true;
+        }
+        m_bufferPosition = position() + n;
+        m_begin = m_end = 0;
+        return true;
+    }
+
+    void seek(uint64_t position) noexcept {
+        if ((m_bufferPosition <= position) && (position <= m_bufferPosition + m_end)) {
+            m_begin = static_cast<std::size_t>(position - m_bufferPosition);
+        } else {
+            m_bufferPosition = position;
+            m_begin = m_end = 0;
+        }
+    }
+
+    bool readVarInt(uint64_t& value) noexcept {
+        value = 0;
+        uint8_t b { 0 };
+        for (uint8_t shift { 0 }; shift < 64; shift = static_cast<uint8_t>(shift + 7)) {
+            if (!read(b)) {
+                return false;
+            }
+            value |= static_cast<uint64_t>(b & 0x7f) << shift;
+            if (0 == (b & 0x80)) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+   private:
+    bool refill() noexcept {
+        m_bufferPosition += m_end;
+        m_begin = m_end = 0;
+        const ssize_t N { ::pread(m_fd, m_buffer.data(), m_buffer.size(), static_cast<off_t>(m_bufferPosition)) };
+        if (0 >= N) {
+            return false;
+        }
+        m_end = static_cast<std::size_t>(N);
+        m_bytesRead += static_cast<uint64_t>(N);
+        return true;
+    }
+
+   private:
+    int m_fd;
+    std::vector<char> m_buffer;
+    uint64_t m_bufferPosition;
+    std::size_t m_begin;
+    std::size_t m_end;
+    uint64_t m_bytesRead;
+};
+
+constexpr std::size_t ChunkedFileReader::CHUNK_SIZE;
+
+int32_t fromZigZag32(uint64_t v) noexcept {
+    const uint32_t ZIGZAG { static_cast<uint32_t>(v) };
+    return static_cast<int32_t>((ZIGZAG >> 1) ^ -(ZIGZAG & 1));
+}
+
+// Skips a proto field of the given wire type.
+bool skipField(ChunkedFileReader& reader, uint8_t wireType) noexcept {
+    uint64_t value { 0 };
+    switch (static_cast<cluon::ProtoConstants>(wireType)) {
+    case cluon::ProtoConstants::VARINT:
+        return reader.readVarInt(value);
+    case cluon::ProtoConstants::LENGTH_DELIMITED:
+        return reader.readVarInt(value) && reader.skip(value);
+    case cluon::ProtoConstants::FOUR_BYTES:
+        return reader.skip(4);
+    case cluon::ProtoConstants::EIGHT_BYTES:
+        return reader.skip(8);
+    }
+    return false;
+}
+
+// Reads the OD4 header and the Envelope fields needed for the index; the
+// payload (serializedData) is skipped, never read into memory or decoded.
+bool readIndexEntry(ChunkedFileReader& reader, RecordingIndexEntry& entry) noexcept {
+    entry = RecordingIndexEntry { 0, reader.position(), 0, 0, 0 };
+    uint8_t header[5] = { 0, 0, 0, 0, 0 };
+    for (auto& b : header) {
+        if (!reader.read(b)) {
+            return false;
+        }
+    }
+    if ((0x0D != header[0]) || (0xA4 != header[1])) {
+        return false;
+    }
+    const uint32_t LENGTH { static_cast<uint32_t>(header[2]) | (static_cast<uint32_t>(header[3]) << 8) | (static_cast<uint32_t>(header[4]) << 16) };
+    const uint64_t END { reader.position() + LENGTH };
+    entry.m_length = static_cast<uint32_t>(sizeof(header)) + LENGTH;
+
+    while (reader.position() < END) {
+        uint64_t key { 0 };
+        uint64_t value { 0 };
+        if (!reader.readVarInt(key)) {
+            return false;
+        }
+        const uint64_t FIELD { key >> 3 };
+        const uint8_t WIRE_TYPE { static_cast<uint8_t>(key & 0x7) };
+        if ((static_cast<uint8_t>(cluon::ProtoConstants::VARINT) == WIRE_TYPE) && ((1 == FIELD) || (6 == FIELD))) {
+            if (!reader.readVarInt(value)) {
+                return false;
+            }
+            if (1 == FIELD) {
+                entry.m_dataType = fromZigZag32(value);
+            } else {
+                entry.m_senderStamp = static_cast<uint32_t>(value);
+            }
+        } else if ((static_cast<uint8_t>(cluon::ProtoConstants::LENGTH_DELIMITED) == WIRE_TYPE) && (5 == FIELD)) {
+            // sampleTimeStamp: seconds (1) and microseconds (2).
+            if (!reader.readVarInt(value)) {
+                return false;
+            }
+            const uint64_t TIMESTAMP_END { reader.position() + value };
+            int64_t seconds { 0 };
+            int64_t microseconds { 0 };
+            while (reader.position() < TIMESTAMP_END) {
+                if (!reader.readVarInt(key)) {
+                    return false;
+                }
+                if ((static_cast<uint8_t>(cluon::ProtoConstants::VARINT) == (key & 0x7)) && ((1 == (key >> 3)) || (2 == (key >> 3)))) {
+                    if (!reader.readVarInt(value)) {
+                        return false;
+                    }
+                    ((1 == (key >> 3)) ? seconds : microseconds) = fromZigZag32(value);
+                } else if (!skipField(reader, static_cast<uint8_t>(key & 0x7))) {
+                    return false;
+                }
+            }
+            entry.m_sampleTimeStamp = seconds * 1000 * 1000 + microseconds;
+        } else if (!skipField(reader, WIRE_TYPE)) {
+            return false;
+        }
+    }
+    return reader.position() == END;
+}
+
+// Entries of all frames starting in [begin, end), in file order.
+struct IndexedRange {
+    uint64_t m_firstFrame { 0 };
+    uint64_t m_nextFrame { 0 };
+    uint64_t m_bytesRead { 0 };
+    std::vector<RecordingIndexEntry> m_entries {};
+};
+
+// A frame at the reader's position is accepted if it parses completely and is
+// followed by another OD4 header or the end of the file.
+bool isFrameStart(ChunkedFileReader& reader, uint64_t position, uint64_t fileSize) noexcept {
+    RecordingIndexEntry entry {};
+    reader.seek(position);
+    if (!readIndexEntry(reader, entry)) {
+        return false;
+    }
+    const uint64_t NEXT { reader.position() };
+    uint8_t b0 { 0 };
+    uint8_t b1 { 0 };
+    return (NEXT == fileSize) || ((NEXT < fileSize) && reader.read(b0) && reader.read(b1) && (0x0D == b0) && (0xA4 == b1));
+}
+
+void indexRange(int fd, uint64_t begin, uint64_t end, uint64_t fileSize, IndexedRange& range) noexcept {
+    ChunkedFileReader reader(fd, begin);
+    uint64_t position { begin };
+    if (0 < begin) {
+        // Resynchronize on the next 0x0D 0xA4 that starts a valid frame.
+        uint8_t previous { 0 };
+        uint8_t b { 0 };
+        bool synchronized { false };
+        while (!synchronized && reader.read(b)) {
+            const uint64_t CANDIDATE { reader.position() - 2 };
+            if (CANDIDATE >= end) {
+                break;
+            }
+            if ((0x0D == previous) && (0xA4 == b)) {
+                synchronized = isFrameStart(reader, CANDIDATE, fileSize);
+                if (synchronized) {
+                    position = CANDIDATE;
+                } else {
+                    reader.seek(CANDIDATE + 2);
+                    b = 0;
+                }
+            }
+            previous = b;
+        }
+        if (!synchronized) {
+            // No frame starts in this range.
+            range.m_firstFrame = range.m_nextFrame = end;
+            range.m_bytesRead = reader.bytesRead();
+            return;
+        }
+    }
+
+    range.m_firstFrame = position;
+    reader.seek(position);
+    RecordingIndexEntry entry {};
+    while ((reader.position() < end) && readIndexEntry(reader, entry)) {
+        range.m_entries.push_back(entry);
+    }
+    range.m_nextFrame = reader.position();
+    range.m_bytesRead = reader.bytesRead();
+}
+
+template <typename T>
+bool readColumn(std::istream& in, std::vector<RecordingIndexEntry>& entries, T RecordingIndexEntry::*field) {
+    std::vector<T> column(entries.size());
+    in.read(reinterpret_cast<char*>(column.data()), static_cast<std::streamsize>(column.size() * sizeof(T)));
+    if (!in.good()) {
+        return false;
+    }
+    for (std::size_t i { 0 }; i < entries.size(); i++) {
+        entries[i].*field = column[i];
+    }
+    return true;
+}
+}
+
+RecordingIndex::RecordingIndex(const std::string& recFile, uint32_t numberOfThreads)
+    : m_file(recFile)
+    , m_numberOfThreads(numberOfThreads)
+    , m_valid(false)
+    , m_loadedFromSidecar(false)
+    , m_fileSize(0)
+    , m_fileModificationTime(0)
+    , m_entries() {
+    struct stat st {};
+    if (0 != ::stat(m_file.c_str(), &st)) {
+        std::clog << "[RecordingIndex]: " << m_file << " could not be opened." << std::endl;
+        return;
+    }
+    m_fileSize = static_cast<uint64_t>(st.st_size);
+    m_fileModificationTime = static_cast<int64_t>(st.st_mtim.tv_sec) * 1000000000L + st.st_mtim.tv_nsec;
+
+    m_loadedFromSidecar = loadSidecar();
+    if (!m_loadedFromSidecar) {
+        build();
+        if (m_valid && !writeSidecar()) {
+            std::clog << "[RecordingIndex]: Could not write " << sidecarFileName(m_file) << "." << std::endl;
+        }
+    }
+}
+
+bool RecordingIndex::valid() const noexcept {
+    return m_valid;
+}
+
+bool RecordingIndex::loadedFromSidecar() const noexcept {
+    return m_loadedFromSidecar;
+}
+
+const std::string& RecordingIndex::file() const noexcept {
+    return m_file;
+}
+
+uint64_t RecordingIndex::fileSize() const noexcept {
+    return m_fileSize;
+}
+
+const std::vector<RecordingIndexEntry>& RecordingIndex::entries() const noexcept {
+    return m_entries;
+}
+
+std::string RecordingIndex::sidecarFileName(const std::string& recFile) {
+    return recFile + ".idx";
+}
+
+bool RecordingIndex::loadSidecar() {
+    std::ifstream in(sidecarFileName(m_file), std::ios_base::in | std::ios_base::binary);
+    if (!in.good()) {
+        return false;
+    }
+
+    SidecarHeader header {};
+    in.read(reinterpret_cast<char*>(&header), sizeof(SidecarHeader));
+    if (!in.good() || !std::equal(std::begin(SIDECAR_MAGIC), std::end(SIDECAR_MAGIC), header.m_magic)
+        || (SIDECAR_BYTE_ORDER != header.m_byteOrder) || (m_fileSize != header.m_recFileSize)
+        || (m_fileModificationTime != header.m_recFileModificationTime)
+        || (header.m_numberOfEntries > m_fileSize)) {
+        std::clog << "[RecordingIndex]: " << sidecarFileName(m_file) << " is stale; re-indexing." << std::endl;
+        return false;
+    }
+
+    std::vector<RecordingIndexEntry> entries(static_cast<std::size_t>(header.m_numberOfEntries));
+    if (!readColumn(in, entries, &RecordingIndexEntry::m_sampleTimeStamp) || !readColumn(in, entries, &RecordingIndexEntry::m_filePosition)
+        || !readColumn(in, entries, &RecordingIndexEntry::m_dataType) || !readColumn(in, entries, &RecordingIndexEntry::m_senderStamp)
+        || !readColumn(in, entries, &RecordingIndexEntry::m_length)) {
+        return false;
+    }
+    m_entries = std::move(entries);
+    m_valid = true;
+    return true;
+}
+
+void RecordingIndex::build() {
+    const int FD { ::open(m_file.c_str(), O_RDONLY | O_CLOEXEC) };
+    if (-1 == FD) {
+        std::clog << "[RecordingIndex]: " << m_file << " could not be opened." << std::endl;
+        return;
+    }
+    ::posix_fadvise(FD, 0, 0, POSIX_FADV_SEQUENTIAL);
+
+    const cluon::data::TimeStamp BEFORE { cluon::time::now() };
+
+    // Split large files into one byte range per core.
+    constexpr uint64_t MIN_RANGE_SIZE { 64 * 1024 * 1024 };
+    const uint64_t THREADS { (0 < m_numberOfThreads) ? m_numberOfThreads : (std::max)(std::thread::hardware_concurrency(), 1u) };
+    const uint64_t NUMBER_OF_RANGES { (std::max)(static_cast<uint64_t>(1), (std::min)(THREADS, m_fileSize / MIN_RANGE_SIZE)) };
+    const uint64_t RANGE_SIZE { m_fileSize / NUMBER_OF_RANGES };
+
+    std::vector<IndexedRange> ranges(static_cast<std::size_t>(NUMBER_OF_RANGES));
+    {
+        std::vector<std::thread> workers;
+        for (uint64_t i { 1 }; i < NUMBER_OF_RANGES; i++) {
+            const uint64_t END { (NUMBER_OF_RANGES - 1 == i) ? m_fileSize : (i + 1) * RANGE_SIZE };
+            workers.emplace_back(indexRange, FD, i * RANGE_SIZE, END, m_fileSize, std::ref(ranges[static_cast<std::size_t>(i)]));
+        }
+        indexRange(FD, 0, (1 == NUMBER_OF_RANGES) ? m_fileSize : RANGE_SIZE, m_fileSize, ranges[0]);
+        for (auto& w : workers) {
+            w.join();
+        }
+    }
+
+    // Each range must continue exactly where the previous one stopped; otherwise a
+    // resynchronization hit a false header and the file is indexed sequentially.
+    bool consistent { true };
+    for (std::size_t i { 1 }; i < ranges.size(); i++) {
+        consistent = consistent && (ranges[i - 1].m_nextFrame == ranges[i].m_firstFrame);
+    }
+    if (!consistent) {
+        std::clog << "[RecordingIndex]: Ranges of " << m_file << " do not line up; indexing sequentially." << std::endl;
+        ranges.assign(1, IndexedRange {});
+        indexRange(FD, 0, m_fileSize, m_fileSize, ranges[0]);
+    }
+    ::close(FD);
+
+    // Sort each range on its own thread's data, then merge the sorted runs in file order.
+    uint64_t bytesRead { 0 };
+    std::vector<std::size_t> runEnds;
+    for (auto& r : ranges) {
+        std::stable_sort(r.m_entries.begin(), r.m_entries.end(), [](const RecordingIndexEntry& a, const RecordingIndexEntry& b) {
+            return a.m_sampleTimeStamp < b.m_sampleTimeStamp;
+        });
+        m_entries.insert(m_entries.end(), r.m_entries.begin(), r.m_entries.end());
+        runEnds.push_back(m_entries.size());
+        bytesRead += r.m_bytesRead;
+        r.m_entries = std::vector<RecordingIndexEntry>();
+    }
+    for (std::size_t i { 1 }; i < runEnds.size(); i++) {
+        std::inplace_merge(m_entries.begin(), m_entries.begin() + static_cast<std::ptrdiff_t>(runEnds[i - 1]),
+            m_entries.begin() + static_cast<std::ptrdiff_t>(runEnds[i]), [](const RecordingIndexEntry& a, const RecordingIndexEntry& b) {
+                return a.m_sampleTimeStamp < b.m_sampleTimeStamp;
+            });
+    }
+    const cluon::data::TimeStamp AFTER { cluon::time::now() };
+    m_valid = true;
+
+    const int64_t DURATION { (std::max)(cluon::time::deltaInMicroseconds(AFTER, BEFORE), static_cast<int64_t>(1)) };
+    std::clog << "[RecordingIndex]: " << m_file << " contains " << m_entries.size() << " entries; read " << bytesRead << " of "
+              << m_fileSize << " bytes with " << ranges.size() << " thread(s) in " << DURATION / 1000 << "ms ("
+              << static_cast<double>(m_fileSize) / static_cast<double>(DURATION) / 1000.0 << " GB/s)." << std::endl;
+}
+
+bool RecordingIndex::writeSidecar() const {
+    // Write to a temporary file first so that readers never see a partial sidecar.
+    const std::string SIDECAR { sidecarFileName(m_file) };
+    const std::string TMP { SIDECAR + ".tmp" };
+    {
+        std::ofstream out(TMP, std::ios_base::out | std::ios_base::binary | std::ios_base::trunc);
+        if (!out.good()) {
+            return false;
+        }
+        SidecarHeader header {};
+        std::copy(std::begin(SIDECAR_MAGIC), std::end(SIDECAR_MAGIC), header.m_magic);
+        header.m_byteOrder = SIDECAR_BYTE_ORDER;
+        header.m_numberOfEntries = m_entries.size();
+        header.m_recFileSize = m_fileSize;
+        header.m_recFileModificationTime = m_fileModificationTime;
+        out.write(reinterpret_cast<const char*>(&header), sizeof(SidecarHeader));
+        writeColumn(out, m_entries, &RecordingIndexEntry::m_sampleTimeStamp);
+        writeColumn(out, m_entries, &RecordingIndexEntry::m_filePosition);
+        writeColumn(out, m_entries, &RecordingIndexEntry::m_dataType);
+        writeColumn(out, m_entries, &RecordingIndexEntry::m_senderStamp);
+        writeColumn(out, m_entries, &RecordingIndexEntry::m_length);
+        out.flush();
+        if (!out.good()) {
+            std::remove(TMP.c_str());
+            return false;
+        }
+    }
+    return 0 == std::rename(TMP.c_str(), SIDECAR.c_str());
+}
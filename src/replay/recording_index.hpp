@@ -0,0 +1,51 @@
+// Timestamp index of a .rec file, persisted as a "<file>.rec.idx" sidecar so
+// that reopening a recording does not need to scan the whole file again.
+#ifndef RECORDING_INDEX_H
+#define RECORDING_INDEX_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+struct RecordingIndexEntry {
+    int64_t m_sampleTimeStamp;
+    uint64_t m_filePosition;
+    int32_t m_dataType;
+    uint32_t m_senderStamp;
+    // Size of the OD4 frame including its 5-byte header.
+    uint32_t m_length;
+};
+
+class RecordingIndex {
+   public:
+    // Loads the sidecar when it matches the recording's size and mtime;
+    // otherwise indexes the recording and (re)writes the sidecar. Large files are
+    // indexed in parallel byte ranges; numberOfThreads = 0 uses all cores.
+    explicit RecordingIndex(const std::string& recFile, uint32_t numberOfThreads = 0);
+
+    bool valid() const noexcept;
+    bool loadedFromSidecar() const noexcept;
+    const std::string& file() const noexcept;
+    uint64_t fileSize() const noexcept;
+
+    // Entries sorted by sample time stamp; equal time stamps keep file order.
+    const std::vector<RecordingIndexEntry>& entries() const noexcept;
+
+    static std::string sidecarFileName(const std::string& recFile);
+
+   private:
+    bool loadSidecar();
+    void build();
+    bool writeSidecar() const;
+
+   private:
+    std::string m_file;
+    uint32_t m_numberOfThreads;
+    bool m_valid;
+    bool m_loadedFromSidecar;
+    uint64_t m_fileSize;
+    int64_t m_fileModificationTime;
+    std::vector<RecordingIndexEntry> m_entries;
+};
+
+#endif
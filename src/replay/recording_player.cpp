@@ -0,0 +1,167 @@
+#include "recording_player.hpp"
+#include <algorithm>
+
+constexpr int64_t EnvelopeFilter::ANY_SENDER_STAMP;
+constexpr uint32_t RecordingPlayer::MAX_DELAY_IN_MICROSECONDS;
+
+bool RecordingPlayer::parse(const std::string& name, Source& source) noexcept {
+    if ("mmap" == name) {
+        source = Source::MAPPED;
+        return true;
+    }
+    if ("read-ahead" == name) {
+        source = Source::READ_AHEAD;
+        return true;
+    }
+    return false;
+}
+
+RecordingPlayer::RecordingPlayer(const std::string& file, bool autoRewind, const std::vector<EnvelopeFilter>& filter, Source source, std::size_t cacheBudget)
+    : m_autoRewind(autoRewind)
+    , m_filter(filter)
+    , m_index(file)
+    , m_filteredEntries()
+    , m_recording(file)
+    , m_readAhead()
+    , m_cacheBudget(cacheBudget)
+    , m_releasedUpTo(0)
+    , m_mappedMetrics()
+    , m_current(0)
+    , m_previousSampleTimeStamp(0)
+    , m_delay(0) {
+    if (!m_filter.empty()) {
+        for (const auto& e : m_index.entries()) {
+            if (matches(e)) {
+                m_filteredEntries.push_back(e);
+            }
+        }
+        m_filteredEntries.shrink_to_fit();
+        // Matching envelopes are scattered over the file.
+        m_recording.adviseRandom();
+    }
+    if (Source::READ_AHEAD == source) {
+        m_readAhead.reset(new ReadAheadEngine(file, entries(), m_cacheBudget));
+    }
+    rewind();
+}
+
+bool RecordingPlayer::matches(const RecordingIndexEntry& entry) const noexcept {
+    for (const auto& f : m_filter) {
+        if ((f.m_dataType == entry.m_dataType) && ((EnvelopeFilter::ANY_SENDER_STAMP == f.m_senderStamp) || (f.m_senderStamp == entry.m_senderStamp))) {
+            return true;
+        }
+    }
+    return false;
+}
+
+const std::vector<RecordingIndexEntry>& RecordingPlayer::entries() const noexcept {
+    return m_filter.empty() ? m_index.entries() : m_filteredEntries;
+}
+
+std::pair<bool, cluon::data::Envelope> RecordingPlayer::getNextEnvelopeToBeReplayed() noexcept {
+    auto retVal = getNextEnvelopeViewToBeReplayed();
+    if (!retVal.first) {
+        return std::make_pair(false, cluon::data::Envelope());
+    }
+    try {
+        return std::make_pair(true, toEnvelope(retVal.second));
+    } catch (...) {
+        return std::make_pair(false, cluon::data::Envelope());
+    }
+}
+
+std::pair<bool, EnvelopeView> RecordingPlayer::getNextEnvelopeViewToBeReplayed() noexcept {
+    const auto& list = entries();
+    if ((m_current == list.size()) && m_autoRewind) {
+        rewind();
+    }
+
+    EnvelopeView view;
+    if ((m_current < list.size()) && (m_readAhead ? m_readAhead->next(view) : m_recording.viewAt(list[m_current], view))) {
+        const int64_t SAMPLE_TIME_STAMP { list[m_current].m_sampleTimeStamp };
+        m_delay = static_cast<uint32_t>((std::min)(SAMPLE_TIME_STAMP - m_previousSampleTimeStamp, static_cast<int64_t>(MAX_DELAY_IN_MICROSECONDS)));
+        m_previousSampleTimeStamp = SAMPLE_TIME_STAMP;
+        if (!m_readAhead) {
+            releaseReplayedPages(list[m_current]);
+        }
+        m_current++;
+        return std::make_pair(true, view);
+    }
+    return std::make_pair(false, view);
+}
+
+void RecordingPlayer::releaseReplayedPages(const RecordingIndexEntry& entry) noexcept {
+    // Entries are in sample time order, so file positions mostly grow; pages
+    // released too early are just faulted in again.
+    if (entry.m_filePosition < m_releasedUpTo) {
+        m_releasedUpTo = entry.m_filePosition;
+    } else if (entry.m_filePosition - m_releasedUpTo > m_cacheBudget) {
+        const uint64_t END { entry.m_filePosition - m_cacheBudget / 2 };
+        m_recording.release(m_releasedUpTo, END - m_releasedUpTo);
+        m_mappedMetrics.m_evictedBytes += END - m_releasedUpTo;
+        m_releasedUpTo = END;
+    }
+    m_mappedMetrics.m_residentBytes = entry.m_filePosition + entry.m_length - m_releasedUpTo;
+    m_mappedMetrics.m_peakResidentBytes = (std::max)(m_mappedMetrics.m_peakResidentBytes, m_mappedMetrics.m_residentBytes);
+}
+
+ReplayCacheMetrics RecordingPlayer::cacheMetrics() const noexcept {
+    return m_readAhead ? m_readAhead->metrics() : m_mappedMetrics;
+}
+
+uint32_t RecordingPlayer::delay() const noexcept {
+    return m_delay;
+}
+
+bool RecordingPlayer::hasMoreData() const noexcept {
+    return m_index.valid() && (m_readAhead ? m_readAhead->valid() : m_recording.valid()) && (m_autoRewind || (m_current < entries().size()));
+}
+
+void RecordingPlayer::rewind() noexcept {
+    m_current = 0;
+    m_delay = 0;
+    m_previousSampleTimeStamp = firstSampleTimeStamp();
+    if (m_readAhead) {
+        m_readAhead->seek(m_current);
+    }
+    if (m_filter.empty()) {
+        m_recording.adviseSequential();
+    }
+}
+
+void RecordingPlayer::seekTo(float ratio) noexcept {
+    if (!(ratio < 0) && !(ratio > 1)) {
+        const auto& list = entries();
+        m_current = (std::min)(static_cast<std::size_t>(static_cast<float>(list.size()) * ratio), list.size());
+        m_delay = 0;
+        m_previousSampleTimeStamp = (m_current < list.size()) ? list[m_current].m_sampleTimeStamp : lastSampleTimeStamp();
+        if (m_readAhead) {
+            m_readAhead->seek(m_current);
+        }
+    }
+}
+
+void RecordingPlayer::seekToTimeStamp(int64_t sampleTimeStamp) noexcept {
+    const auto& list = entries();
+    auto it = std::lower_bound(list.begin(), list.end(), sampleTimeStamp, [](const RecordingIndexEntry& e, int64_t ts) {
+        return e.m_sampleTimeStamp < ts;
+    });
+    m_current = static_cast<std::size_t>(it - list.begin());
+    m_delay = 0;
+    m_previousSampleTimeStamp = (it != list.end()) ? it->m_sampleTimeStamp : lastSampleTimeStamp();
+    if (m_readAhead) {
+        m_readAhead->seek(m_current);
+    }
+}
+
+uint32_t RecordingPlayer::totalNumberOfEnvelopesInRecFile() const noexcept {
+    return static_cast<uint32_t>(entries().size());
+}
+
+int64_t RecordingPlayer::firstSampleTimeStamp() const noexcept {
+    return entries().empty() ? 0 : entries().front().m_sampleTimeStamp;
+}
+
+int64_t RecordingPlayer::lastSampleTimeStamp() const noexcept {
+    return entries().empty() ? 0 : entries().back().m_sampleTimeStamp;
+}
@@ -0,0 +1,99 @@
+// Replays a .rec file in sample time order. Compared to cluon::Player, the index
+// is a flat sorted array (RecordingIndex) and envelopes are read straight from
+// the memory-mapped file, so there is no envelope cache and no cache thread.
+// For cold storage, Source::READ_AHEAD keeps many reads in flight instead.
+// A RecordingPlayer is meant to be used from a single thread.
+#ifndef RECORDING_PLAYER_H
+#define RECORDING_PLAYER_H
+
+#include "cluon-complete.hpp"
+#include <replay/envelope_view.hpp>
+#include <replay/mapped_recording.hpp>
+#include <replay/read_ahead.hpp>
+#include <replay/recording_index.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Selects envelopes by dataType and, optionally, senderStamp.
+struct EnvelopeFilter {
+    static constexpr int64_t ANY_SENDER_STAMP { -1 };
+
+    int32_t m_dataType;
+    int64_t m_senderStamp { ANY_SENDER_STAMP };
+};
+
+class RecordingPlayer {
+   private:
+    RecordingPlayer(const RecordingPlayer&) = delete;
+    RecordingPlayer(RecordingPlayer&&) = delete;
+    RecordingPlayer& operator=(const RecordingPlayer&) = delete;
+    RecordingPlayer& operator=(RecordingPlayer&&) = delete;
+
+   public:
+    static constexpr uint32_t MAX_DELAY_IN_MICROSECONDS { 1000 * 1000 };
+
+    // MAPPED reads envelopes through page faults on the memory-mapped file;
+    // READ_AHEAD issues asynchronous reads for upcoming entries (ReadAheadEngine).
+    enum class Source { MAPPED, READ_AHEAD };
+
+    // Parses "mmap" or "read-ahead", as given to --replay-source.
+    static bool parse(const std::string& name, Source& source) noexcept;
+
+    // With a non-empty filter, only matching envelopes are indexed for replay and
+    // read from disk; all others are skipped entirely. cacheBudget caps the bytes
+    // kept resident: READ_AHEAD buffers at most that much ahead of replay, MAPPED
+    // releases pages once that much has been replayed past them.
+    RecordingPlayer(const std::string& file, bool autoRewind, const std::vector<EnvelopeFilter>& filter = {}, Source source = Source::MAPPED, std::size_t cacheBudget = ReadAheadEngine::DEFAULT_BYTE_BUDGET);
+
+    // Same contract as cluon::Player::getNextEnvelopeToBeReplayed; copies the payload.
+    std::pair<bool, cluon::data::Envelope> getNextEnvelopeToBeReplayed() noexcept;
+
+    // Zero-copy variant; with Source::MAPPED the view stays valid as long as the
+    // player lives, with Source::READ_AHEAD only until the next call.
+    std::pair<bool, EnvelopeView> getNextEnvelopeViewToBeReplayed() noexcept;
+
+    // Delay in microseconds between the last two replayed envelopes, capped at one second.
+    uint32_t delay() const noexcept;
+
+    bool hasMoreData() const noexcept;
+    void rewind() noexcept;
+
+    // Seeks to the given fraction of entries.
+    void seekTo(float ratio) noexcept;
+    // Seeks to the first entry with a sample time stamp not before the given one (microseconds).
+    void seekToTimeStamp(int64_t sampleTimeStamp) noexcept;
+
+    // Hits and misses are only tracked with Source::READ_AHEAD.
+    ReplayCacheMetrics cacheMetrics() const noexcept;
+
+    uint32_t totalNumberOfEnvelopesInRecFile() const noexcept;
+    int64_t firstSampleTimeStamp() const noexcept;
+    int64_t lastSampleTimeStamp() const noexcept;
+
+   private:
+    bool matches(const RecordingIndexEntry& entry) const noexcept;
+    const std::vector<RecordingIndexEntry>& entries() const noexcept;
+    void releaseReplayedPages(const RecordingIndexEntry& entry) noexcept;
+
+   private:
+    bool m_autoRewind;
+    std::vector<EnvelopeFilter> m_filter;
+    RecordingIndex m_index;
+    std::vector<RecordingIndexEntry> m_filteredEntries;
+    MappedRecording m_recording;
+    std::unique_ptr<ReadAheadEngine> m_readAhead;
+    std::size_t m_cacheBudget;
+    // Start of the mapped range not yet released (MAPPED only).
+    uint64_t m_releasedUpTo;
+    ReplayCacheMetrics m_mappedMetrics;
+
+    std::size_t m_current;
+    int64_t m_previousSampleTimeStamp;
+    uint32_t m_delay;
+};
+
+#endif
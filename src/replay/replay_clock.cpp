@@ -0,0 +1,93 @@
+#include "replay_clock.hpp"
+#include <replay/recording_player.hpp>
+#include <cstdlib>
+
+bool ReplayClock::parse(const std::string& speed, Mode& mode, float& factor) noexcept {
+    factor = 1.0f;
+    if ("max" == speed) {
+        mode = Mode::AS_FAST_AS_POSSIBLE;
+        return true;
+    }
+    if ("step" == speed) {
+        mode = Mode::STEP;
+        return true;
+    }
+    char* end { nullptr };
+    factor = std::strtof(speed.c_str(), &end);
+    if (speed.empty() || ('\0' != *end) || !(factor > 0.0f)) {
+        factor = 1.0f;
+        return false;
+    }
+    mode = (!(factor < 1.0f) && !(factor > 1.0f)) ? Mode::REALTIME : Mode::SCALED;
+    return true;
+}
+
+ReplayClock::ReplayClock(Mode mode, float speed)
+    : m_mode(mode)
+    , m_speed((Mode::REALTIME == mode) || !(speed > 0.0f) ? 1.0f : speed)
+    , m_mutex()
+    , m_condition()
+    , m_anchored(false)
+    , m_anchorTime()
+    , m_anchorSampleTimeStamp(0)
+    , m_lastSampleTimeStamp(0)
+    , m_steps(0)
+    , m_stopped(false) {}
+
+ReplayClock::Mode ReplayClock::mode() const noexcept {
+    return m_mode;
+}
+
+float ReplayClock::speed() const noexcept {
+    return m_speed;
+}
+
+bool ReplayClock::waitUntil(int64_t sampleTimeStamp) noexcept {
+    std::unique_lock<std::mutex> lck(m_mutex);
+    if (!m_anchored || (sampleTimeStamp < m_lastSampleTimeStamp)) {
+        // Start of replay, after reset(), or the recording was rewound.
+        m_anchored = true;
+        m_anchorTime = std::chrono::steady_clock::now();
+        m_anchorSampleTimeStamp = sampleTimeStamp;
+    } else if (sampleTimeStamp - m_lastSampleTimeStamp > RecordingPlayer::MAX_DELAY_IN_MICROSECONDS) {
+        m_anchorSampleTimeStamp += sampleTimeStamp - m_lastSampleTimeStamp - RecordingPlayer::MAX_DELAY_IN_MICROSECONDS;
+    }
+    m_lastSampleTimeStamp = sampleTimeStamp;
+
+    if (Mode::STEP == m_mode) {
+        m_condition.wait(lck, [this]() { return m_stopped || (0 < m_steps); });
+        if (0 < m_steps) {
+            m_steps--;
+        }
+    } else if (Mode::AS_FAST_AS_POSSIBLE != m_mode) {
+        const auto DUE { m_anchorTime + std::chrono::microseconds(static_cast<int64_t>(static_cast<double>(sampleTimeStamp - m_anchorSampleTimeStamp) / static_cast<double>(m_speed))) };
+        m_condition.wait_until(lck, DUE, [this]() { return m_stopped; });
+    }
+    return !m_stopped;
+}
+
+void ReplayClock::step(uint32_t steps) noexcept {
+    {
+        std::lock_guard<std::mutex> lck(m_mutex);
+        m_steps += steps;
+    }
+    m_condition.notify_all();
+}
+
+void ReplayClock::reset() noexcept {
+    std::lock_guard<std::mutex> lck(m_mutex);
+    m_anchored = false;
+}
+
+void ReplayClock::stop() noexcept {
+    {
+        std::lock_guard<std::mutex> lck(m_mutex);
+        m_stopped = true;
+    }
+    m_condition.notify_all();
+}
+
+cluon::data::TimeStamp ReplayClock::now() const noexcept {
+    std::lock_guard<std::mutex> lck(m_mutex);
+    return cluon::time::fromMicroseconds(m_lastSampleTimeStamp);
+}
@@ -0,0 +1,62 @@
+// Paces replay by sample time stamps: in real time, N times faster or slower,
+// as fast as possible, or one step at a time for reproducing single frames.
+#ifndef REPLAY_CLOCK_H
+#define REPLAY_CLOCK_H
+
+#include "cluon-complete.hpp"
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+
+class ReplayClock {
+   private:
+    ReplayClock(const ReplayClock&) = delete;
+    ReplayClock(ReplayClock&&) = delete;
+    ReplayClock& operator=(const ReplayClock&) = delete;
+    ReplayClock& operator=(ReplayClock&&) = delete;
+
+   public:
+    enum class Mode { REALTIME, SCALED, AS_FAST_AS_POSSIBLE, STEP };
+
+    // Parses "max", "step" or a speed factor like "1" or "2.5".
+    static bool parse(const std::string& speed, Mode& mode, float& factor) noexcept;
+
+    explicit ReplayClock(Mode mode = Mode::REALTIME, float speed = 1.0f);
+
+    Mode mode() const noexcept;
+    float speed() const noexcept;
+
+    // Blocks until data sampled at sampleTimeStamp (microseconds) is due; gaps in
+    // the recording are capped like RecordingPlayer::delay(). Returns false once
+    // the clock is stopped.
+    bool waitUntil(int64_t sampleTimeStamp) noexcept;
+
+    // Lets the given number of waitUntil calls pass in Mode::STEP.
+    void step(uint32_t steps = 1) noexcept;
+
+    // Re-anchors pacing at the next waitUntil, e.g. after seeking.
+    void reset() noexcept;
+
+    // Unblocks all current and future waitUntil calls.
+    void stop() noexcept;
+
+    // Sample time stamp of the last waitUntil, to be used instead of wall time.
+    cluon::data::TimeStamp now() const noexcept;
+
+   private:
+    const Mode m_mode;
+    const float m_speed;
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_condition;
+    bool m_anchored;
+    std::chrono::steady_clock::time_point m_anchorTime;
+    int64_t m_anchorSampleTimeStamp;
+    int64_t m_lastSampleTimeStamp;
+    uint32_t m_steps;
+    bool m_stopped;
+};
+
+#endif
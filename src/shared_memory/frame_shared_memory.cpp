@@ -0,0 +1,374 @@
+#include "frame_shared_memory.hpp"
+#include <atomic>
+#include <cerrno>
+#include <climits>
+#include <cstring>
+#include <fcntl.h>
+#include <fstream>
+#include <iostream>
+#include <linux/futex.h>
+#include <linux/mempolicy.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+constexpr uint32_t MAGIC { fourcc('F', 'R', 'M', '1') };
+constexpr uint32_t VERSION { 2 };
+
+void futexWait(const std::atomic<uint32_t>* word, uint32_t expected, std::chrono::nanoseconds timeout) noexcept {
+    struct timespec ts;
+    ts.tv_sec = static_cast<time_t>(timeout.count() / 1000000000);
+    ts.tv_nsec = static_cast<long>(timeout.count() % 1000000000);
+    // Not FUTEX_PRIVATE: producer and consumer are different processes.
+    ::syscall(SYS_futex, reinterpret_cast<const uint32_t*>(word), FUTEX_WAIT, expected, &ts, nullptr, 0);
+}
+
+// Mount point of the default hugetlbfs.
+const char* HUGETLBFS { "/dev/hugepages" };
+
+std::size_t hugePageSize() noexcept {
+    std::ifstream meminfo("/proc/meminfo");
+    std::string key;
+    std::size_t sizeInKiB { 0 };
+    while (meminfo >> key) {
+        if ("Hugepagesize:" == key) {
+            meminfo >> sizeInKiB;
+            break;
+        }
+        meminfo.ignore(256, '\n');
+    }
+    return sizeInKiB * 1024;
+}
+
+void cpuRelax() noexcept {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__) || defined(__arm__)
+    asm volatile("yield");
+#endif
+}
+
+void futexWakeAll(std::atomic<uint32_t>* word) noexcept {
+    ::syscall(SYS_futex, reinterpret_cast<uint32_t*>(word), FUTEX_WAKE, INT_MAX, nullptr, nullptr, 0);
+}
+}
+
+// Placed at the start of the area, followed by the slot headers and the slots'
+// pixel data. The fields are atomics so that the seqlock readers are race-free.
+struct FrameSharedMemoryHeader {
+    std::atomic<uint32_t> m_magic;
+    uint32_t m_version;
+    uint32_t m_headerSize;
+    uint32_t m_size;
+    uint32_t m_slotStride;
+    uint32_t m_numberOfSlots;
+
+    // Futex word: lower 32 bits of m_latestFrameNumber.
+    alignas(64) std::atomic<uint32_t> m_published;
+    std::atomic<uint64_t> m_latestFrameNumber;
+};
+
+// Frame n goes to slot n % numberOfSlots. All fields but m_sequence are
+// accessed relaxed and ordered by m_sequence.
+struct FrameSlotHeader {
+    // Seqlock: odd while the producer writes into this slot.
+    alignas(64) std::atomic<uint32_t> m_sequence;
+    std::atomic<uint32_t> m_pixelFormat;
+    std::atomic<uint32_t> m_width;
+    std::atomic<uint32_t> m_height;
+    std::atomic<uint32_t> m_frameSize;
+    std::atomic<int64_t> m_sampleTimeStamp;
+    std::atomic<uint64_t> m_frameNumber;
+};
+
+constexpr uint32_t FrameSharedMemory::MIN_SLOTS;
+constexpr uint32_t FrameSharedMemory::MAX_SLOTS;
+constexpr int32_t FrameSharedMemoryOptions::NO_NUMA_NODE;
+constexpr int32_t FrameSharedMemoryOptions::LOCAL_NUMA_NODE;
+
+FrameSharedMemory::FrameSharedMemory(const std::string& name, uint32_t size, uint32_t numberOfSlots, const FrameSharedMemoryOptions& options) noexcept
+    : m_name(((name.empty()) || ('/' != name[0])) ? "/" + name : name)
+    , m_isProducer(0 < size)
+    , m_hugePagesFile()
+    , m_fd(-1)
+    , m_mapping(nullptr)
+    , m_mappingSize(0)
+    , m_header(nullptr)
+    , m_slots(nullptr)
+    , m_data(nullptr)
+    , m_size(0)
+    , m_slotStride(0)
+    , m_numberOfSlots(0)
+    , m_writing(0) {
+    static_assert(ATOMIC_INT_LOCK_FREE == 2 && ATOMIC_LLONG_LOCK_FREE == 2, "Atomics in shared memory must be lock-free.");
+
+    if (m_isProducer && (numberOfSlots < MIN_SLOTS)) {
+        std::cerr << "[FrameSharedMemory]: " << m_name << " needs at least " << MIN_SLOTS << " slots." << std::endl;
+        return;
+    }
+    // Keep the slot headers and each slot's pixel data cache line aligned.
+    numberOfSlots = (numberOfSlots > MAX_SLOTS) ? MAX_SLOTS : numberOfSlots;
+    const uint32_t HEADER_SIZE { static_cast<uint32_t>((sizeof(FrameSharedMemoryHeader) + numberOfSlots * sizeof(FrameSlotHeader) + 63) & ~static_cast<std::size_t>(63)) };
+    const uint32_t SLOT_STRIDE { (size + 63) & ~static_cast<uint32_t>(63) };
+
+    if (m_isProducer) {
+        m_mappingSize = static_cast<std::size_t>(HEADER_SIZE) + static_cast<std::size_t>(SLOT_STRIDE) * numberOfSlots;
+
+        if (!options.m_hugePages || !createOnHugePages(m_mappingSize)) {
+            m_fd = ::shm_open(m_name.c_str(), O_CREAT | O_EXCL | O_RDWR, S_IRUSR | S_IWUSR);
+            if ((-1 == m_fd) && (EEXIST == errno)) {
+                // Left over from a producer that did not shut down cleanly.
+                ::shm_unlink(m_name.c_str());
+                m_fd = ::shm_open(m_name.c_str(), O_CREAT | O_EXCL | O_RDWR, S_IRUSR | S_IWUSR);
+            }
+            if ((-1 == m_fd) || (0 != ::ftruncate(m_fd, static_cast<off_t>(m_mappingSize)))) {
+                std::cerr << "[FrameSharedMemory]: Failed to create " << m_name << ": " << std::strerror(errno) << std::endl;
+                return;
+            }
+        }
+    } else {
+        m_fd = ::shm_open(m_name.c_str(), O_RDWR, S_IRUSR | S_IWUSR);
+        if (-1 == m_fd) {
+            // The producer may have placed the area on huge pages.
+            m_fd = ::open((HUGETLBFS + m_name).c_str(), O_RDWR | O_CLOEXEC);
+            m_hugePagesFile = (-1 == m_fd) ? "" : HUGETLBFS + m_name;
+        }
+        struct stat st;
+        if ((-1 == m_fd) || (0 != ::fstat(m_fd, &st)) || (static_cast<std::size_t>(st.st_size) < sizeof(FrameSharedMemoryHeader))) {
+            return;
+        }
+        m_mappingSize = static_cast<std::size_t>(st.st_size);
+    }
+
+    void* mapping { ::mmap(nullptr, m_mappingSize, PROT_READ | PROT_WRITE, MAP_SHARED, m_fd, 0) };
+    if (MAP_FAILED == mapping) {
+        std::cerr << "[FrameSharedMemory]: Failed to map " << m_name << ": " << std::strerror(errno) << std::endl;
+        return;
+    }
+    m_mapping = static_cast<char*>(mapping);
+    FrameSharedMemoryHeader* header { reinterpret_cast<FrameSharedMemoryHeader*>(m_mapping) };
+
+    if (m_isProducer) {
+        place(options);
+        header->m_version = VERSION;
+        header->m_headerSize = HEADER_SIZE;
+        header->m_size = size;
+        header->m_slotStride = SLOT_STRIDE;
+        header->m_numberOfSlots = numberOfSlots;
+        header->m_published.store(0, std::memory_order_relaxed);
+        header->m_latestFrameNumber.store(0, std::memory_order_relaxed);
+        FrameSlotHeader* slots { reinterpret_cast<FrameSlotHeader*>(m_mapping + sizeof(FrameSharedMemoryHeader)) };
+        for (uint32_t i { 0 }; i < numberOfSlots; i++) {
+            slots[i].m_sequence.store(0, std::memory_order_relaxed);
+            slots[i].m_frameNumber.store(0, std::memory_order_relaxed);
+        }
+        // Consumers only attach once the header is complete.
+        header->m_magic.store(MAGIC, std::memory_order_release);
+    } else if ((MAGIC != header->m_magic.load(std::memory_order_acquire)) || (VERSION != header->m_version) || (header->m_numberOfSlots < MIN_SLOTS)
+               || (header->m_numberOfSlots > MAX_SLOTS) || (header->m_headerSize < sizeof(FrameSharedMemoryHeader) + header->m_numberOfSlots * sizeof(FrameSlotHeader))
+               || (header->m_slotStride < header->m_size)
+               || (m_mappingSize < static_cast<std::size_t>(header->m_headerSize) + static_cast<std::size_t>(header->m_slotStride) * header->m_numberOfSlots)) {
+        return;
+    } else {
+        // Only now that the area is known to be ours, e.g. not a cluon::SharedMemory.
+        place(options);
+    }
+    m_header = header;
+    m_slots = reinterpret_cast<FrameSlotHeader*>(m_mapping + sizeof(FrameSharedMemoryHeader));
+    m_data = m_mapping + header->m_headerSize;
+    m_size = header->m_size;
+    m_slotStride = header->m_slotStride;
+    m_numberOfSlots = header->m_numberOfSlots;
+    m_writing = header->m_latestFrameNumber.load(std::memory_order_relaxed);
+}
+
+FrameSharedMemory::~FrameSharedMemory() noexcept {
+    if (nullptr != m_mapping) {
+        ::munmap(m_mapping, m_mappingSize);
+    }
+    if (-1 != m_fd) {
+        ::close(m_fd);
+        if (m_isProducer) {
+            if (m_hugePagesFile.empty()) {
+                ::shm_unlink(m_name.c_str());
+            } else {
+                ::unlink(m_hugePagesFile.c_str());
+            }
+        }
+    }
+}
+
+bool FrameSharedMemory::createOnHugePages(std::size_t size) noexcept {
+    const std::size_t HUGE_PAGE_SIZE { hugePageSize() };
+    if (0 == HUGE_PAGE_SIZE) {
+        std::clog << "[FrameSharedMemory]: No huge pages available; using normal pages for " << m_name << "." << std::endl;
+        return false;
+    }
+    const std::string HUGE_PAGES_FILE { HUGETLBFS + m_name };
+    m_fd = ::open(HUGE_PAGES_FILE.c_str(), O_CREAT | O_EXCL | O_RDWR | O_CLOEXEC, S_IRUSR | S_IWUSR);
+    if ((-1 == m_fd) && (EEXIST == errno)) {
+        // Left over from a producer that did not shut down cleanly.
+        ::unlink(HUGE_PAGES_FILE.c_str());
+        m_fd = ::open(HUGE_PAGES_FILE.c_str(), O_CREAT | O_EXCL | O_RDWR | O_CLOEXEC, S_IRUSR | S_IWUSR);
+    }
+    // hugetlbfs files are sized in whole huge pages.
+    const std::size_t ROUNDED_SIZE { (size + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE };
+    if ((-1 == m_fd) || (0 != ::ftruncate(m_fd, static_cast<off_t>(ROUNDED_SIZE)))) {
+        std::clog << "[FrameSharedMemory]: Cannot use huge pages from " << HUGETLBFS << " (" << std::strerror(errno) << "); using normal pages for " << m_name << "." << std::endl;
+        if (-1 != m_fd) {
+            ::close(m_fd);
+            ::unlink(HUGE_PAGES_FILE.c_str());
+            m_fd = -1;
+        }
+        return false;
+    }
+    m_hugePagesFile = HUGE_PAGES_FILE;
+    m_mappingSize = ROUNDED_SIZE;
+    return true;
+}
+
+void FrameSharedMemory::place(const FrameSharedMemoryOptions& options) noexcept {
+    int32_t node { options.m_numaNode };
+    if (FrameSharedMemoryOptions::LOCAL_NUMA_NODE == node) {
+        unsigned cpu { 0 };
+        unsigned localNode { 0 };
+        node = (0 == ::syscall(SYS_getcpu, &cpu, &localNode, nullptr)) ? static_cast<int32_t>(localNode) : FrameSharedMemoryOptions::NO_NUMA_NODE;
+    }
+    if (0 <= node) {
+        const std::size_t BITS { 8 * sizeof(unsigned long) };
+        std::vector<unsigned long> nodeMask(static_cast<std::size_t>(node) / BITS + 1, 0);
+        nodeMask[static_cast<std::size_t>(node) / BITS] = 1UL << (static_cast<std::size_t>(node) % BITS);
+        if (0 != ::syscall(SYS_mbind, m_mapping, m_mappingSize, MPOL_BIND, nodeMask.data(), nodeMask.size() * BITS + 1, MPOL_MF_MOVE)) {
+            std::clog << "[FrameSharedMemory]: Could not bind " << m_name << " to NUMA node " << node << ": " << std::strerror(errno) << std::endl;
+        }
+    }
+    if (options.m_prefault) {
+        const std::size_t PAGE_SIZE { m_hugePagesFile.empty() ? static_cast<std::size_t>(::sysconf(_SC_PAGESIZE)) : hugePageSize() };
+        volatile char* p { m_mapping };
+        for (std::size_t offset { 0 }; offset < m_mappingSize; offset += PAGE_SIZE) {
+            // The producer allocates the (still zeroed) pages, consumers map them.
+            if (m_isProducer) {
+                p[offset] = 0;
+            } else {
+                static_cast<void>(p[offset]);
+            }
+        }
+    }
+}
+
+bool FrameSharedMemory::valid() const noexcept {
+    return nullptr != m_header;
+}
+
+const std::string& FrameSharedMemory::name() const noexcept {
+    return m_name;
+}
+
+uint32_t FrameSharedMemory::size() const noexcept {
+    return m_size;
+}
+
+uint32_t FrameSharedMemory::numberOfSlots() const noexcept {
+    return m_numberOfSlots;
+}
+
+bool FrameSharedMemory::usesHugePages() const noexcept {
+    return !m_hugePagesFile.empty();
+}
+
+char* FrameSharedMemory::beginFrame() noexcept {
+    if (nullptr == m_header) {
+        return nullptr;
+    }
+    m_writing = m_header->m_latestFrameNumber.load(std::memory_order_relaxed) + 1;
+    const uint32_t SLOT { static_cast<uint32_t>(m_writing % m_numberOfSlots) };
+    m_slots[SLOT].m_sequence.store(m_slots[SLOT].m_sequence.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    // The odd sequence must be visible before any pixel is written.
+    std::atomic_thread_fence(std::memory_order_release);
+    return m_data + static_cast<std::size_t>(SLOT) * m_slotStride;
+}
+
+void FrameSharedMemory::endFrame(FrameInfo info) noexcept {
+    if (nullptr != m_header) {
+        FrameSlotHeader& slot = m_slots[m_writing % m_numberOfSlots];
+        slot.m_pixelFormat.store(static_cast<uint32_t>(info.m_pixelFormat), std::memory_order_relaxed);
+        slot.m_width.store(info.m_width, std::memory_order_relaxed);
+        slot.m_height.store(info.m_height, std::memory_order_relaxed);
+        slot.m_frameSize.store((info.m_size < m_size) ? info.m_size : m_size, std::memory_order_relaxed);
+        slot.m_sampleTimeStamp.store(info.m_sampleTimeStamp, std::memory_order_relaxed);
+        slot.m_frameNumber.store(m_writing, std::memory_order_relaxed);
+        slot.m_sequence.store(slot.m_sequence.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+
+        m_header->m_latestFrameNumber.store(m_writing, std::memory_order_release);
+        m_header->m_published.store(static_cast<uint32_t>(m_writing), std::memory_order_release);
+        futexWakeAll(&m_header->m_published);
+    }
+}
+
+bool FrameSharedMemory::frameInfo(FrameInfo& info) const noexcept {
+    return copyFrame(nullptr, 0, info);
+}
+
+bool FrameSharedMemory::copyFrame(char* destination, std::size_t capacity, FrameInfo& info) const noexcept {
+    if (nullptr == m_header) {
+        return false;
+    }
+    for (;;) {
+        const uint64_t LATEST { m_header->m_latestFrameNumber.load(std::memory_order_acquire) };
+        if (0 == LATEST) {
+            return false;
+        }
+        const uint32_t SLOT { static_cast<uint32_t>(LATEST % m_numberOfSlots) };
+        const FrameSlotHeader& slot = m_slots[SLOT];
+        const uint32_t BEFORE { slot.m_sequence.load(std::memory_order_acquire) };
+        // An odd sequence or another frame number means the producer lapped the ring.
+        if ((0 != (BEFORE & 1)) || (LATEST != slot.m_frameNumber.load(std::memory_order_relaxed))) {
+            continue;
+        }
+        info.m_frameNumber = LATEST;
+        info.m_sampleTimeStamp = slot.m_sampleTimeStamp.load(std::memory_order_relaxed);
+        info.m_pixelFormat = static_cast<PixelFormat>(slot.m_pixelFormat.load(std::memory_order_relaxed));
+        info.m_width = slot.m_width.load(std::memory_order_relaxed);
+        info.m_height = slot.m_height.load(std::memory_order_relaxed);
+        info.m_size = slot.m_frameSize.load(std::memory_order_relaxed);
+        if (nullptr != destination) {
+            if (info.m_size > capacity) {
+                return false;
+            }
+            std::memcpy(destination, m_data + static_cast<std::size_t>(SLOT) * m_slotStride, info.m_size);
+        }
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (BEFORE == slot.m_sequence.load(std::memory_order_relaxed)) {
+            return true;
+        }
+    }
+}
+
+bool FrameSharedMemory::waitForFrame(uint64_t frameNumber, std::chrono::nanoseconds timeout, uint32_t spins) const noexcept {
+    if (nullptr == m_header) {
+        return false;
+    }
+    for (uint32_t i { 0 }; i < spins; i++) {
+        if (m_header->m_latestFrameNumber.load(std::memory_order_acquire) != frameNumber) {
+            return true;
+        }
+        cpuRelax();
+    }
+    const auto DEADLINE { std::chrono::steady_clock::now() + timeout };
+    for (;;) {
+        const uint32_t PUBLISHED { m_header->m_published.load(std::memory_order_acquire) };
+        if (m_header->m_latestFrameNumber.load(std::memory_order_acquire) != frameNumber) {
+            return true;
+        }
+        // Futex waits end early on signals and spurious wake-ups.
+        const auto REMAINING { DEADLINE - std::chrono::steady_clock::now() };
+        if (REMAINING <= std::chrono::nanoseconds::zero()) {
+            return false;
+        }
+        futexWait(&m_header->m_published, PUBLISHED, std::chrono::duration_cast<std::chrono::nanoseconds>(REMAINING));
+    }
+}
@@ -0,0 +1,116 @@
+// Shared memory area for camera frames that carries the frame's metadata (sample
+// time stamp, frame number, pixel format, geometry) in its own header. Frames go
+// round-robin into a ring of slots, each published with seqlock semantics: the
+// producer writes slot N+1 while readers copy slot N, readers never take a lock
+// or issue a syscall, and only retry when the producer lapped the whole ring.
+//
+// This is an opt-in transport: it needs a producer built on this class, and the
+// h264decoder writes plain cluon::SharedMemory areas, which are captured as
+// before (FrameSource tells the two apart by this area's header).
+#ifndef FRAME_SHARED_MEMORY_H
+#define FRAME_SHARED_MEMORY_H
+
+#include <shared_memory/pixel_format.hpp>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+struct FrameInfo {
+    // Number of frames published so far; 0 before the first frame.
+    uint64_t m_frameNumber { 0 };
+    // Sample time stamp in nanoseconds.
+    int64_t m_sampleTimeStamp { 0 };
+    PixelFormat m_pixelFormat { PixelFormat::UNKNOWN };
+    uint32_t m_width { 0 };
+    uint32_t m_height { 0 };
+    // Bytes of pixel data in the frame.
+    uint32_t m_size { 0 };
+};
+
+// Placement of the area's memory.
+struct FrameSharedMemoryOptions {
+    static constexpr int32_t NO_NUMA_NODE { -1 };
+    static constexpr int32_t LOCAL_NUMA_NODE { -2 };
+
+    // Producer only: back the area with huge pages from hugetlbfs to save TLB
+    // misses when copying and converting frames; falls back to normal pages.
+    bool m_hugePages { false };
+    // Binds the area's memory to a NUMA node, LOCAL_NUMA_NODE being the node of
+    // the calling thread's CPU; pages already allocated elsewhere are migrated
+    // where the kernel permits.
+    int32_t m_numaNode { NO_NUMA_NODE };
+    // Faults all pages in up front instead of during the first frames.
+    bool m_prefault { false };
+};
+
+struct FrameSharedMemoryHeader;
+struct FrameSlotHeader;
+
+class FrameSharedMemory {
+   private:
+    FrameSharedMemory(const FrameSharedMemory&) = delete;
+    FrameSharedMemory(FrameSharedMemory&&) = delete;
+    FrameSharedMemory& operator=(const FrameSharedMemory&) = delete;
+    FrameSharedMemory& operator=(FrameSharedMemory&&) = delete;
+
+   public:
+    // With a single slot, a producer dying mid-write would leave readers
+    // retrying forever; from two on the previous frame stays readable.
+    static constexpr uint32_t MIN_SLOTS { 2 };
+    static constexpr uint32_t MAX_SLOTS { 16 };
+
+    // Like cluon::SharedMemory, a size (per frame) creates the area as its
+    // producer and 0 attaches to an existing one; the name gets a leading '/' if
+    // missing. Creating more than MAX_SLOTS slots uses MAX_SLOTS; creating fewer
+    // than MIN_SLOTS fails, as does attaching to areas not created by a
+    // FrameSharedMemory. Consumers only apply the options to such areas.
+    explicit FrameSharedMemory(const std::string& name, uint32_t size = 0, uint32_t numberOfSlots = 3, const FrameSharedMemoryOptions& options = {}) noexcept;
+    ~FrameSharedMemory() noexcept;
+
+    bool valid() const noexcept;
+    const std::string& name() const noexcept;
+    // Capacity for pixel data per frame.
+    uint32_t size() const noexcept;
+    uint32_t numberOfSlots() const noexcept;
+    bool usesHugePages() const noexcept;
+
+    // Producer: returns the slot to write the next frame's pixels to, which is
+    // published by endFrame().
+    char* beginFrame() noexcept;
+    // Publishes the frame with the given metadata; m_frameNumber is assigned.
+    void endFrame(FrameInfo info) noexcept;
+
+    // Consumer: metadata of the latest frame; false before the first frame.
+    bool frameInfo(FrameInfo& info) const noexcept;
+    // Copies the latest frame's pixels; false before the first frame or if
+    // capacity is too small. Gaps in m_frameNumber are dropped frames.
+    bool copyFrame(char* destination, std::size_t capacity, FrameInfo& info) const noexcept;
+    // Waits until a frame newer than the given frame number is published; false
+    // on timeout. Polls up to spins times before sleeping on a futex, which
+    // saves the wake-up latency when frames arrive back to back.
+    bool waitForFrame(uint64_t frameNumber, std::chrono::nanoseconds timeout, uint32_t spins = 0) const noexcept;
+
+   private:
+    bool createOnHugePages(std::size_t size) noexcept;
+    void place(const FrameSharedMemoryOptions& options) noexcept;
+
+   private:
+    std::string m_name;
+    bool m_isProducer;
+    // Path of the area on hugetlbfs; empty for POSIX shared memory.
+    std::string m_hugePagesFile;
+    int m_fd;
+    char* m_mapping;
+    std::size_t m_mappingSize;
+    FrameSharedMemoryHeader* m_header;
+    FrameSlotHeader* m_slots;
+    char* m_data;
+    uint32_t m_size;
+    uint32_t m_slotStride;
+    uint32_t m_numberOfSlots;
+    // Producer only.
+    uint64_t m_writing;
+};
+
+#endif
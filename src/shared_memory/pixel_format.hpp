@@ -0,0 +1,46 @@
+// Pixel formats of camera frames, shared by the frame transport and the detectors.
+#ifndef PIXEL_FORMAT_H
+#define PIXEL_FORMAT_H
+
+#include <cstdint>
+#include <string>
+
+constexpr uint32_t fourcc(char a, char b, char c, char d) noexcept {
+    return static_cast<uint32_t>(static_cast<uint8_t>(a)) | (static_cast<uint32_t>(static_cast<uint8_t>(b)) << 8) | (static_cast<uint32_t>(static_cast<uint8_t>(c)) << 16) | (static_cast<uint32_t>(static_cast<uint8_t>(d)) << 24);
+}
+
+// Pixel formats are FourCC codes naming the bytes in memory order.
+enum class PixelFormat : uint32_t {
+    UNKNOWN = 0,
+    BGRA = fourcc('B', 'G', 'R', 'A'),
+    ARGB = fourcc('A', 'R', 'G', 'B'),
+    BGR = fourcc('B', 'G', 'R', '3'),
+    I420 = fourcc('I', '4', '2', '0'),
+    NV12 = fourcc('N', 'V', '1', '2'),
+};
+
+// Parses a format name as used on the command line; UNKNOWN for any other.
+inline PixelFormat pixelFormat(const std::string& name) noexcept {
+    return ("bgra" == name) ? PixelFormat::BGRA
+        : ("argb" == name)  ? PixelFormat::ARGB
+        : ("bgr" == name)   ? PixelFormat::BGR
+        : ("i420" == name)  ? PixelFormat::I420
+        : ("nv12" == name)  ? PixelFormat::NV12
+                            : PixelFormat::UNKNOWN;
+}
+
+// Bytes of a width x height frame; 0 for unknown formats and for YUV 4:2:0
+// with odd dimensions.
+inline uint64_t frameSize(PixelFormat format, uint32_t width, uint32_t height) noexcept {
+    const uint64_t PIXELS { static_cast<uint64_t>(width) * height };
+    switch (format) {
+        case PixelFormat::BGRA:
+        case PixelFormat::ARGB: return PIXELS * 4;
+        case PixelFormat::BGR: return PIXELS * 3;
+        case PixelFormat::I420:
+        case PixelFormat::NV12: return ((0 == width % 2) && (0 == height % 2)) ? PIXELS * 3 / 2 : 0;
+        default: return 0;
+    }
+}
+
+#endif
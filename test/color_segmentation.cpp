@@ -0,0 +1,173 @@
+// segmentColors() converts each pixel to HSV in registers instead of going
+// through OpenCV; its masks must be identical to cv::cvtColor() to BGR and HSV
+// followed by cv::inRange(), for every pixel format. Checks all 2^24 BGR
+// colours and all 2^24 YUV triples, and random frames in every layout with an
+// ROI at odd coordinates.
+#include <cone_detection/cone_detector.hpp>
+#include <opencv2/imgproc/imgproc.hpp>
+#include <array>
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+const std::size_t NUMBER_OF_RANGES { 4 };
+
+// The detector's cone colours, a red wrapping around H = 0 and one with
+// bounds outside the value ranges.
+std::array<HsvRange, NUMBER_OF_RANGES> ranges() {
+    const ConeDetectorOptions OPTIONS;
+    return { { OPTIONS.m_blue, OPTIONS.m_yellow, hsvRange(cv::Scalar(0, 50, 50), cv::Scalar(10, 255, 255)), hsvRange(cv::Scalar(170, -5, 20), cv::Scalar(300, 200, 260)) } };
+}
+
+const char* name(PixelFormat format) {
+    switch (format) {
+        case PixelFormat::BGRA: return "BGRA";
+        case PixelFormat::ARGB: return "ARGB";
+        case PixelFormat::BGR: return "BGR";
+        case PixelFormat::I420: return "I420";
+        case PixelFormat::NV12: return "NV12";
+        default: return "unknown";
+    }
+}
+
+// The frame as BGR image through OpenCV.
+cv::Mat toBgr(PixelFormat format, const cv::Mat& frame) {
+    cv::Mat bgr;
+    switch (format) {
+        case PixelFormat::BGRA: cv::cvtColor(frame, bgr, cv::COLOR_BGRA2BGR); break;
+        case PixelFormat::ARGB: {
+            // OpenCV has no conversion from ARGB; reorder the bytes instead.
+            bgr.create(frame.rows, frame.cols, CV_8UC3);
+            const int FROM_TO[] { 3, 0, 2, 1, 1, 2 };
+            cv::mixChannels(&frame, 1, &bgr, 1, FROM_TO, 3);
+            break;
+        }
+        case PixelFormat::BGR: bgr = frame; break;
+        case PixelFormat::I420: cv::cvtColor(frame, bgr, cv::COLOR_YUV2BGR_I420); break;
+        case PixelFormat::NV12: cv::cvtColor(frame, bgr, cv::COLOR_YUV2BGR_NV12); break;
+        default: break;
+    }
+    return bgr;
+}
+
+// Number of pixels in which segmentColors() and OpenCV disagree.
+uint64_t differences(PixelFormat format, const cv::Mat& frame, const cv::Rect& roi) {
+    const std::array<HsvRange, NUMBER_OF_RANGES> RANGES { ranges() };
+    std::array<cv::Mat, NUMBER_OF_RANGES> masks;
+    segmentColors(format, frame, roi, RANGES, masks);
+
+    cv::Mat hsv;
+    cv::cvtColor(toBgr(format, frame), hsv, cv::COLOR_BGR2HSV);
+    uint64_t count { 0 };
+    for (std::size_t i { 0 }; i < NUMBER_OF_RANGES; i++) {
+        const HsvRange& RANGE { RANGES[i] };
+        cv::Mat expected;
+        cv::inRange(hsv, cv::Scalar(RANGE.m_lower[0], RANGE.m_lower[1], RANGE.m_lower[2]), cv::Scalar(RANGE.m_upper[0], RANGE.m_upper[1], RANGE.m_upper[2]), expected);
+        for (int y { 0 }; y < roi.height; y++) {
+            const uint8_t* expectedRow { expected.ptr<uint8_t>(roi.y + y) + roi.x };
+            const uint8_t* actualRow { masks[i].ptr<uint8_t>(y) };
+            for (int x { 0 }; x < roi.width; x++) {
+                count += (expectedRow[x] != actualRow[x]) ? 1 : 0;
+            }
+        }
+    }
+    return count;
+}
+
+// Every BGR colour once, in a 4096x4096 frame.
+cv::Mat allColours() {
+    cv::Mat frame(4096, 4096, CV_8UC3);
+    for (int y { 0 }; y < frame.rows; y++) {
+        uint8_t* row { frame.ptr<uint8_t>(y) };
+        for (int x { 0 }; x < frame.cols; x++) {
+            row[3 * x + 0] = static_cast<uint8_t>(x & 0xff);
+            row[3 * x + 1] = static_cast<uint8_t>(y & 0xff);
+            row[3 * x + 2] = static_cast<uint8_t>((x >> 8) | ((y >> 8) << 4));
+        }
+    }
+    return frame;
+}
+
+// A 512x512 YUV 4:2:0 frame whose 2x2 blocks have every chroma pair once,
+// with the lumas 4 * part to 4 * part + 3; parts 0 to 63 cover all triples.
+cv::Mat allYuv(PixelFormat format, int part) {
+    const int SIZE { 512 };
+    cv::Mat frame(SIZE * 3 / 2, SIZE, CV_8UC1);
+    uint8_t* luma { frame.ptr<uint8_t>(0) };
+    uint8_t* chroma { luma + SIZE * SIZE };
+    for (int y { 0 }; y < SIZE; y++) {
+        for (int x { 0 }; x < SIZE; x++) {
+            luma[y * SIZE + x] = static_cast<uint8_t>(4 * part + 2 * (y % 2) + x % 2);
+        }
+    }
+    for (int v { 0 }; v < SIZE / 2; v++) {
+        for (int u { 0 }; u < SIZE / 2; u++) {
+            if (PixelFormat::I420 == format) {
+                chroma[v * (SIZE / 2) + u] = static_cast<uint8_t>(u);
+                chroma[(SIZE / 2) * (SIZE / 2) + v * (SIZE / 2) + u] = static_cast<uint8_t>(v);
+            } else {
+                chroma[v * SIZE + 2 * u] = static_cast<uint8_t>(u);
+                chroma[v * SIZE + 2 * u + 1] = static_cast<uint8_t>(v);
+            }
+        }
+    }
+    return frame;
+}
+
+// A 160x120 frame of random bytes in the given layout.
+cv::Mat randomFrame(PixelFormat format, std::mt19937& random) {
+    const int WIDTH { 160 };
+    const int HEIGHT { 120 };
+    cv::Mat frame;
+    switch (format) {
+        case PixelFormat::BGRA:
+        case PixelFormat::ARGB: frame.create(HEIGHT, WIDTH, CV_8UC4); break;
+        case PixelFormat::BGR: frame.create(HEIGHT, WIDTH, CV_8UC3); break;
+        default: frame.create(HEIGHT * 3 / 2, WIDTH, CV_8UC1); break;
+    }
+    std::uniform_int_distribution<int> byte(0, 255);
+    for (int y { 0 }; y < frame.rows; y++) {
+        uint8_t* row { frame.ptr<uint8_t>(y) };
+        for (std::size_t x { 0 }; x < static_cast<std::size_t>(frame.cols) * frame.elemSize(); x++) {
+            row[x] = static_cast<uint8_t>(byte(random));
+        }
+    }
+    return frame;
+}
+
+bool report(const std::string& what, uint64_t differences) {
+    if (0 < differences) {
+        std::cerr << what << ": " << differences << " mask pixels differ from OpenCV." << std::endl;
+        return false;
+    }
+    std::clog << what << ": identical to OpenCV." << std::endl;
+    return true;
+}
+}
+
+int main() {
+    bool ok { true };
+    const cv::Mat ALL_COLOURS { allColours() };
+    ok = report("All BGR colours", differences(PixelFormat::BGR, ALL_COLOURS, cv::Rect(0, 0, ALL_COLOURS.cols, ALL_COLOURS.rows))) && ok;
+    for (const PixelFormat FORMAT : { PixelFormat::I420, PixelFormat::NV12 }) {
+        uint64_t count { 0 };
+        for (int part { 0 }; part < 64; part++) {
+            const cv::Mat FRAME { allYuv(FORMAT, part) };
+            count += differences(FORMAT, FRAME, cv::Rect(0, 0, FRAME.cols, FRAME.rows * 2 / 3));
+        }
+        ok = report(std::string("All ") + name(FORMAT) + " triples", count) && ok;
+    }
+
+    std::mt19937 random { 47 };
+    for (const PixelFormat FORMAT : { PixelFormat::BGRA, PixelFormat::ARGB, PixelFormat::BGR, PixelFormat::I420, PixelFormat::NV12 }) {
+        uint64_t count { 0 };
+        for (int i { 0 }; i < 20; i++) {
+            count += differences(FORMAT, randomFrame(FORMAT, random), cv::Rect(3, 37, 151, 41));
+        }
+        ok = report(std::string("Random ") + name(FORMAT) + " frames", count) && ok;
+    }
+    return ok ? 0 : 1;
+}
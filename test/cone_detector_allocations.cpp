@@ -0,0 +1,275 @@
+// ConeDetector keeps its working memory in a FrameArena, so once it has seen a
+// frame, further frames of the same size must not touch the heap. Global
+// operator new and delete are replaced by counting versions; cv::Mat buffers
+// count as well, as OpenCV allocates the UMatData of each with new.
+//
+// FrameArena's own Canny and contour tracing must also give the boxes of
+// cv::Canny, cv::findContours(RETR_TREE) and cv::boundingRect, in the same
+// order, as the nearest cone depends on it.
+#include <cone_detection/cone_detector.hpp>
+#include <opencv2/imgproc/imgproc.hpp>
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <random>
+#include <vector>
+
+static std::atomic<uint64_t> g_allocations { 0 };
+
+void* operator new(std::size_t size) {
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    void* p { std::malloc((0 < size) ? size : 1) };
+    if (nullptr == p) {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void* operator new[](std::size_t size) {
+    return operator new(size);
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    return std::malloc((0 < size) ? size : 1);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t& tag) noexcept {
+    return operator new(size, tag);
+}
+
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete[](void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept {
+    std::free(p);
+}
+
+void operator delete[](void* p, std::size_t) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, const std::nothrow_t&) noexcept {
+    std::free(p);
+}
+
+void operator delete[](void* p, const std::nothrow_t&) noexcept {
+    std::free(p);
+}
+
+namespace {
+const int WIDTH { 640 };
+const int HEIGHT { 480 };
+const int NUMBER_OF_FRAMES { 50 };
+
+// A grey frame with a blue cone left and a yellow cone right in the ROI that
+// move with the frame number, in the given layout.
+cv::Mat makeFrame(PixelFormat format, int frameNumber) {
+    const int TOP { 280 + frameNumber % 40 };
+    const int BLUE_LEFT { 100 + 2 * frameNumber };
+    const int YELLOW_LEFT { 500 - 2 * frameNumber };
+    auto inCone = [TOP](int x, int y, int left) { return (y >= TOP) && (y < TOP + 40) && (x >= left) && (x < left + 30); };
+
+    if (PixelFormat::BGRA == format) {
+        cv::Mat frame(HEIGHT, WIDTH, CV_8UC4);
+        for (int y { 0 }; y < HEIGHT; y++) {
+            uint8_t* row { frame.ptr<uint8_t>(y) };
+            for (int x { 0 }; x < WIDTH; x++) {
+                const bool BLUE { inCone(x, y, BLUE_LEFT) };
+                const bool YELLOW { inCone(x, y, YELLOW_LEFT) };
+                row[4 * x + 0] = BLUE ? 255 : (YELLOW ? 0 : 128);
+                row[4 * x + 1] = BLUE ? 0 : (YELLOW ? 255 : 128);
+                row[4 * x + 2] = BLUE ? 0 : (YELLOW ? 255 : 128);
+                row[4 * x + 3] = 255;
+            }
+        }
+        return frame;
+    }
+
+    // I420: the luma plane, then the U and V planes at half resolution.
+    cv::Mat frame(HEIGHT * 3 / 2, WIDTH, CV_8UC1);
+    uint8_t* luma { frame.ptr<uint8_t>(0) };
+    uint8_t* u { luma + WIDTH * HEIGHT };
+    uint8_t* v { u + (WIDTH / 2) * (HEIGHT / 2) };
+    for (int y { 0 }; y < HEIGHT; y++) {
+        for (int x { 0 }; x < WIDTH; x++) {
+            luma[y * WIDTH + x] = (inCone(x, y, BLUE_LEFT) || inCone(x, y, YELLOW_LEFT)) ? 200 : 128;
+        }
+    }
+    for (int y { 0 }; y < HEIGHT / 2; y++) {
+        for (int x { 0 }; x < WIDTH / 2; x++) {
+            const bool BLUE { inCone(2 * x, 2 * y, BLUE_LEFT) };
+            const bool YELLOW { inCone(2 * x, 2 * y, YELLOW_LEFT) };
+            u[y * (WIDTH / 2) + x] = BLUE ? 200 : (YELLOW ? 50 : 128);
+            v[y * (WIDTH / 2) + x] = BLUE ? 100 : (YELLOW ? 150 : 128);
+        }
+    }
+    return frame;
+}
+
+// Runs all frames through one detector; returns the number of allocations
+// after the first frame, or -1 if a cone was missed.
+int64_t allocationsAfterFirstFrame(PixelFormat format) {
+    std::vector<cv::Mat> frames;
+    for (int i { 0 }; i < NUMBER_OF_FRAMES; i++) {
+        frames.push_back(makeFrame(format, i));
+    }
+    ConeDetector detector;
+    uint64_t allocations { 0 };
+    for (int i { 0 }; i < NUMBER_OF_FRAMES; i++) {
+        const uint64_t BEFORE { g_allocations.load(std::memory_order_relaxed) };
+        const ConeResult CONES { detector.process(FrameView { format, frames[static_cast<std::size_t>(i)] }) };
+        if (0 < i) {
+            allocations += g_allocations.load(std::memory_order_relaxed) - BEFORE;
+        }
+        if ((0 > CONES.m_left.x) || (0 > CONES.m_right.x)) {
+            std::cerr << "Frame " << i << ": cones not found." << std::endl;
+            return -1;
+        }
+    }
+    return static_cast<int64_t>(allocations);
+}
+
+// The boxes as the detector computed them with OpenCV.
+std::vector<cv::Rect> openCvContours(const cv::Mat& mask, int lowThreshold, int highThreshold) {
+    cv::Mat edges;
+    cv::Canny(mask, edges, lowThreshold, highThreshold);
+    std::vector<std::vector<cv::Point>> contours;
+    std::vector<cv::Vec4i> hierarchy;
+    cv::findContours(edges, contours, hierarchy, cv::RETR_TREE, cv::CHAIN_APPROX_SIMPLE);
+    std::vector<cv::Rect> boxes;
+    for (const auto& contour : contours) {
+        boxes.push_back(cv::boundingRect(contour));
+    }
+    return boxes;
+}
+
+// Pixels set with the given probability.
+cv::Mat randomMask(const cv::Size& size, double density, std::mt19937& random) {
+    std::bernoulli_distribution set(density);
+    cv::Mat mask(size.height, size.width, CV_8UC1);
+    for (int y { 0 }; y < size.height; y++) {
+        uint8_t* row { mask.ptr<uint8_t>(y) };
+        for (int x { 0 }; x < size.width; x++) {
+            row[x] = set(random) ? 255 : 0;
+        }
+    }
+    return mask;
+}
+
+// Overlapping ellipses, toggling the pixels they cover, so that they form
+// holes and islands; many reach over the mask's border.
+cv::Mat blobMask(const cv::Size& size, int numberOfBlobs, std::mt19937& random) {
+    cv::Mat mask(size.height, size.width, CV_8UC1);
+    for (int y { 0 }; y < size.height; y++) {
+        std::fill(mask.ptr<uint8_t>(y), mask.ptr<uint8_t>(y) + size.width, 0);
+    }
+    std::uniform_int_distribution<int> centreX(-10, size.width + 10);
+    std::uniform_int_distribution<int> centreY(-10, size.height + 10);
+    std::uniform_int_distribution<int> radius(1, 25);
+    for (int i { 0 }; i < numberOfBlobs; i++) {
+        const int CX { centreX(random) };
+        const int CY { centreY(random) };
+        const int RX { radius(random) };
+        const int RY { radius(random) };
+        for (int y { std::max(0, CY - RY) }; y < std::min(size.height, CY + RY + 1); y++) {
+            uint8_t* row { mask.ptr<uint8_t>(y) };
+            for (int x { std::max(0, CX - RX) }; x < std::min(size.width, CX + RX + 1); x++) {
+                if ((x - CX) * (x - CX) * RY * RY + (y - CY) * (y - CY) * RX * RX <= RX * RX * RY * RY) {
+                    row[x] = static_cast<uint8_t>(255 - row[x]);
+                }
+            }
+        }
+    }
+    return mask;
+}
+
+// Rectangles nested inside each other, alternately set and clear, with a gap
+// of the given width; with an offset, the outer ones are cut by the border.
+cv::Mat nestedMask(const cv::Size& size, int gap, const cv::Point& offset) {
+    cv::Mat mask(size.height, size.width, CV_8UC1);
+    for (int y { 0 }; y < size.height; y++) {
+        uint8_t* row { mask.ptr<uint8_t>(y) };
+        for (int x { 0 }; x < size.width; x++) {
+            const int DEPTH { std::min(std::min(x - offset.x, size.width - 1 - x), std::min(y - offset.y, size.height - 1 - y)) };
+            row[x] = ((0 <= DEPTH) && (0 == (DEPTH / gap) % 2)) ? 255 : 0;
+        }
+    }
+    return mask;
+}
+
+// Returns the number of masks on which FrameArena and OpenCV disagree.
+int contourMismatches() {
+    std::mt19937 random { 49 };
+    std::vector<cv::Mat> masks;
+    for (const cv::Size& SIZE : { cv::Size(1, 1), cv::Size(2, 3), cv::Size(17, 5), cv::Size(5, 17), cv::Size(64, 48), cv::Size(WIDTH, 110) }) {
+        for (const double DENSITY : { 0.05, 0.3, 0.5, 0.7, 0.95 }) {
+            for (int i { 0 }; i < 4; i++) {
+                masks.push_back(randomMask(SIZE, DENSITY, random));
+            }
+        }
+        for (const int BLOBS : { 1, 4, 16, 64 }) {
+            for (int i { 0 }; i < 4; i++) {
+                masks.push_back(blobMask(SIZE, BLOBS, random));
+            }
+        }
+        for (const int GAP : { 1, 2, 3 }) {
+            for (const cv::Point& OFFSET : { cv::Point(0, 0), cv::Point(1, 2), cv::Point(-3, -1) }) {
+                masks.push_back(nestedMask(SIZE, GAP, OFFSET));
+            }
+        }
+    }
+
+    FrameArena arena;
+    int mismatches { 0 };
+    for (const cv::Mat& MASK : masks) {
+        // The detector's thresholds, and ones that leave weak edges to hysteresis.
+        for (const auto& THRESHOLDS : { std::make_pair(50, 150), std::make_pair(400, 1500) }) {
+            const std::vector<cv::Rect> EXPECTED { openCvContours(MASK, THRESHOLDS.first, THRESHOLDS.second) };
+            const std::vector<cv::Rect>& ACTUAL { arena.contours(MASK, THRESHOLDS.first, THRESHOLDS.second) };
+            if (EXPECTED != ACTUAL) {
+                if (0 == mismatches) {
+                    std::size_t i { 0 };
+                    while ((i < EXPECTED.size()) && (i < ACTUAL.size()) && (EXPECTED[i] == ACTUAL[i])) {
+                        i++;
+                    }
+                    std::cerr << "Contours of a " << MASK.cols << "x" << MASK.rows << " mask: " << ACTUAL.size() << " boxes instead of OpenCV's " << EXPECTED.size() << ", first difference at box " << i << "." << std::endl;
+                }
+                mismatches++;
+            }
+        }
+    }
+    std::clog << "Contours: " << masks.size() << " masks compared with OpenCV, " << mismatches << " mismatches." << std::endl;
+    return mismatches;
+}
+}
+
+int main() {
+    int retCode { 0 };
+    for (const PixelFormat FORMAT : { PixelFormat::BGRA, PixelFormat::I420 }) {
+        const int64_t ALLOCATIONS { allocationsAfterFirstFrame(FORMAT) };
+        const char* NAME { (PixelFormat::BGRA == FORMAT) ? "BGRA" : "I420" };
+        if (0 > ALLOCATIONS) {
+            std::cerr << NAME << ": detection failed." << std::endl;
+            retCode = 1;
+        } else if (0 < ALLOCATIONS) {
+            std::cerr << NAME << ": " << ALLOCATIONS << " allocations after the first frame." << std::endl;
+            retCode = 1;
+        } else {
+            std::clog << NAME << ": no allocations after the first of " << NUMBER_OF_FRAMES << " frames." << std::endl;
+        }
+    }
+    if (0 < contourMismatches()) {
+        std::cerr << "Contours differ from OpenCV." << std::endl;
+        retCode = 1;
+    }
+    return retCode;
+}
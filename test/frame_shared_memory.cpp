@@ -0,0 +1,228 @@
+// FrameSharedMemory round trip: a producer thread publishes frames as fast as
+// it can while a consumer waits for and copies them. Every copied frame must
+// be complete and newer than the previous one; FrameSource must count the
+// frames it skipped as dropped. Also covers the areas that must be rejected
+// and waitForFrame()'s timeout and its spinning and sleeping wake-ups.
+#include <ingestion/frame_source.hpp>
+#include <shared_memory/frame_shared_memory.hpp>
+#include "cluon-complete.hpp"
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+const uint32_t WIDTH { 128 };
+const uint32_t HEIGHT { 96 };
+const uint32_t SIZE { WIDTH * HEIGHT * 4 };
+const uint64_t NUMBER_OF_FRAMES { 5000 };
+
+// Unique per process, as tests may run in parallel.
+std::string areaName(const std::string& name) {
+    return "/test-frame-shared-memory-" + name + "-" + std::to_string(::getpid());
+}
+
+// Every byte of frame n is n modulo 251, so that neighbouring frames differ.
+uint8_t pixelValue(uint64_t frameNumber) {
+    return static_cast<uint8_t>(frameNumber % 251);
+}
+
+void publish(FrameSharedMemory& producer, uint64_t frameNumber) {
+    char* pixels { producer.beginFrame() };
+    std::memset(pixels, pixelValue(frameNumber), SIZE);
+    FrameInfo info;
+    info.m_sampleTimeStamp = static_cast<int64_t>(frameNumber) * 1000;
+    info.m_pixelFormat = PixelFormat::BGRA;
+    info.m_width = WIDTH;
+    info.m_height = HEIGHT;
+    info.m_size = SIZE;
+    producer.endFrame(info);
+}
+
+bool check(bool condition, const std::string& message) {
+    if (!condition) {
+        std::cerr << message << std::endl;
+    }
+    return condition;
+}
+
+bool rejectsInvalidAreas() {
+    bool ok { true };
+    {
+        FrameSharedMemory producer { areaName("slots"), SIZE, FrameSharedMemory::MIN_SLOTS - 1 };
+        ok = check(!producer.valid(), "Created a ring with fewer than MIN_SLOTS slots.") && ok;
+    }
+    {
+        FrameSharedMemory producer { areaName("empty"), SIZE };
+        FrameSharedMemory consumer { areaName("empty") };
+        FrameInfo info;
+        std::vector<char> buffer(SIZE);
+        ok = check(consumer.valid(), "Cannot attach to a FrameSharedMemory area.") && ok;
+        ok = check(!consumer.frameInfo(info), "frameInfo() succeeded before the first frame.") && ok;
+        ok = check(!consumer.copyFrame(buffer.data(), buffer.size(), info), "copyFrame() succeeded before the first frame.") && ok;
+    }
+    // cluon::SharedMemory areas in both of its implementations.
+    for (const char* POSIX : { "0", "1" }) {
+        ::setenv("CLUON_SHAREDMEMORY_POSIX", POSIX, 1);
+        cluon::SharedMemory area { areaName(std::string("cluon") + POSIX), SIZE };
+        FrameSharedMemory consumer { areaName(std::string("cluon") + POSIX) };
+        ok = check(area.valid(), "Cannot create a cluon::SharedMemory area.") && ok;
+        ok = check(!consumer.valid(), std::string("Attached to a cluon::SharedMemory area (CLUON_SHAREDMEMORY_POSIX=") + POSIX + ").") && ok;
+    }
+    ::unsetenv("CLUON_SHAREDMEMORY_POSIX");
+    return ok;
+}
+
+// The producer never waits for the consumer, which copies whatever frame is
+// the latest; frames it misses are drops.
+bool roundTrip() {
+    FrameSharedMemory producer { areaName("round-trip"), SIZE };
+    FrameSharedMemory consumer { areaName("round-trip") };
+    if (!check(producer.valid() && consumer.valid(), "Cannot set up the round trip.")) {
+        return false;
+    }
+    std::thread producerThread([&producer]() {
+        for (uint64_t i { 1 }; i <= NUMBER_OF_FRAMES; i++) {
+            publish(producer, i);
+            // Lets the consumer in on a single core, too.
+            std::this_thread::yield();
+        }
+    });
+
+    bool ok { true };
+    std::vector<char> buffer(SIZE);
+    FrameInfo info;
+    uint64_t copied { 0 };
+    uint64_t dropped { 0 };
+    while (ok && (NUMBER_OF_FRAMES != info.m_frameNumber)) {
+        const uint64_t LAST_FRAME_NUMBER { info.m_frameNumber };
+        if (!consumer.waitForFrame(LAST_FRAME_NUMBER, std::chrono::seconds(5))) {
+            ok = check(false, "No frame after " + std::to_string(LAST_FRAME_NUMBER) + ".");
+            break;
+        }
+        ok = check(consumer.copyFrame(buffer.data(), buffer.size(), info), "copyFrame() failed.") && ok;
+        ok = check(info.m_frameNumber > LAST_FRAME_NUMBER, "Frame " + std::to_string(info.m_frameNumber) + " after " + std::to_string(LAST_FRAME_NUMBER) + ".") && ok;
+        ok = check((SIZE == info.m_size) && (WIDTH == info.m_width) && (HEIGHT == info.m_height) && (PixelFormat::BGRA == info.m_pixelFormat), "Wrong metadata.") && ok;
+        ok = check(static_cast<int64_t>(info.m_frameNumber) * 1000 == info.m_sampleTimeStamp, "Time stamp of another frame.") && ok;
+        const uint8_t VALUE { pixelValue(info.m_frameNumber) };
+        const auto TORN { std::find_if(buffer.begin(), buffer.end(), [VALUE](char pixel) { return VALUE != static_cast<uint8_t>(pixel); }) };
+        ok = check(buffer.end() == TORN, "Torn frame " + std::to_string(info.m_frameNumber) + " at byte " + std::to_string(TORN - buffer.begin()) + ".") && ok;
+        copied++;
+        dropped += info.m_frameNumber - LAST_FRAME_NUMBER - 1;
+    }
+    producerThread.join();
+    std::clog << "Round trip: " << copied << " of " << NUMBER_OF_FRAMES << " frames copied, " << dropped << " dropped." << std::endl;
+    return ok && check(NUMBER_OF_FRAMES == copied + dropped, "Frames lost in counting.");
+}
+
+// Without a new frame, waitForFrame() returns false once the timeout passed;
+// a frame published from another thread wakes it up both while it spins and
+// while it sleeps on the futex.
+bool waitsForFrames() {
+    FrameSharedMemory producer { areaName("wait"), SIZE };
+    FrameSharedMemory consumer { areaName("wait") };
+    if (!check(producer.valid() && consumer.valid(), "Cannot set up the waits.")) {
+        return false;
+    }
+    const auto TIMEOUT { std::chrono::milliseconds(200) };
+    bool ok { true };
+    for (const uint32_t SPINS : { 0u, 1000u }) {
+        const auto START { std::chrono::steady_clock::now() };
+        const bool WOKEN { consumer.waitForFrame(0, TIMEOUT, SPINS) };
+        const auto ELAPSED { std::chrono::steady_clock::now() - START };
+        ok = check(!WOKEN, "Woken without a frame (spins " + std::to_string(SPINS) + ").") && ok;
+        ok = check((ELAPSED >= TIMEOUT) && (ELAPSED < TIMEOUT + std::chrono::seconds(1)), "Timeout of " + std::to_string(std::chrono::duration_cast<std::chrono::milliseconds>(ELAPSED).count()) + "ms instead of 200ms.") && ok;
+    }
+
+    // So many spins that the frame arrives while spinning, and few enough
+    // that the consumer goes to sleep first.
+    const auto DELAY { std::chrono::milliseconds(50) };
+    uint64_t frameNumber { 0 };
+    for (const uint32_t SPINS : { 1000000000u, 100u }) {
+        frameNumber++;
+        std::thread producerThread([&producer, frameNumber, DELAY]() {
+            std::this_thread::sleep_for(DELAY);
+            publish(producer, frameNumber);
+        });
+        const auto START { std::chrono::steady_clock::now() };
+        const bool WOKEN { consumer.waitForFrame(frameNumber - 1, std::chrono::seconds(5), SPINS) };
+        const auto ELAPSED { std::chrono::steady_clock::now() - START };
+        producerThread.join();
+        FrameInfo info;
+        ok = check(WOKEN && consumer.frameInfo(info) && (frameNumber == info.m_frameNumber), "Not woken by frame " + std::to_string(frameNumber) + " (spins " + std::to_string(SPINS) + ").") && ok;
+        ok = check(ELAPSED < std::chrono::seconds(2), "Woken after " + std::to_string(std::chrono::duration_cast<std::chrono::milliseconds>(ELAPSED).count()) + "ms (spins " + std::to_string(SPINS) + ").") && ok;
+    }
+    return ok;
+}
+
+// FrameSource copies the latest frame once its delegate returns; frames
+// published meanwhile are skipped and must be counted as dropped.
+bool countsDrops() {
+    FrameSharedMemory producer { areaName("drops"), SIZE };
+    std::mutex mutex;
+    std::condition_variable condition;
+    std::vector<uint64_t> received;
+    bool blocked { true };
+    FrameSource source { 0, areaName("drops"), 0, 0, PixelFormat::BGRA, FrameSharedMemoryOptions(), 0, [&](Frame&& frame) {
+        std::unique_lock<std::mutex> lck(mutex);
+        received.push_back(frame.m_frameNumber);
+        condition.notify_all();
+        // Hold the capture thread in the first frame.
+        condition.wait(lck, [&blocked]() { return !blocked; });
+    } };
+    if (!check(source.valid(), "FrameSource cannot attach.")) {
+        return false;
+    }
+    auto waitForFrames = [&](std::size_t count) {
+        std::unique_lock<std::mutex> lck(mutex);
+        return condition.wait_for(lck, std::chrono::seconds(5), [&]() { return received.size() >= count; });
+    };
+
+    publish(producer, 1);
+    bool ok { check(waitForFrames(1), "Frame 1 not captured.") };
+    for (uint64_t i { 2 }; i <= 5; i++) {
+        publish(producer, i);
+    }
+    {
+        std::lock_guard<std::mutex> lck(mutex);
+        blocked = false;
+        condition.notify_all();
+    }
+    ok = check(waitForFrames(2), "Frame 5 not captured.") && ok;
+    publish(producer, 6);
+    ok = check(waitForFrames(3), "Frame 6 not captured.") && ok;
+
+    std::lock_guard<std::mutex> lck(mutex);
+    ok = check((std::vector<uint64_t> { 1, 5, 6 }) == received, "Captured other frames than 1, 5 and 6.") && ok;
+    return check(3 == source.numberOfDroppedFrames(), "Counted " + std::to_string(source.numberOfDroppedFrames()) + " instead of 3 dropped frames.") && ok;
+}
+}
+
+int main() {
+    int retCode { 0 };
+    if (!rejectsInvalidAreas()) {
+        std::cerr << "Invalid areas: FAILED" << std::endl;
+        retCode = 1;
+    }
+    if (!roundTrip()) {
+        std::cerr << "Round trip: FAILED" << std::endl;
+        retCode = 1;
+    }
+    if (!waitsForFrames()) {
+        std::cerr << "Waiting for frames: FAILED" << std::endl;
+        retCode = 1;
+    }
+    if (!countsDrops()) {
+        std::cerr << "Dropped frames: FAILED" << std::endl;
+        retCode = 1;
+    }
+    return retCode;
+}